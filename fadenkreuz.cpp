@@ -28,12 +28,19 @@ SOFTWARE.
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <tchar.h>
 #include <windows.h>  
 
 #include "gdiplus.h"
 
+#include "overlayexport.h"
 #include "resource.h"
+#include "reticle.h"
+#include "spread.h"
+#include "tiles.h"
+
+#include <vector>
 
 using namespace Gdiplus; 
 
@@ -44,12 +51,14 @@ using namespace Gdiplus;
 // some strings
 #define APPNAME				"Fadenkreuz"								
 #define WINDOW_CLASSNAME	"FadenkreuzClass"
+#define INPUT_CLASSNAME		"FadenkreuzInputClass"
 #define SHAPE_SETTING		"Shape"
 #define COLOR_SETTING		"Color"
 #define SIZE_SETTING		"Size"
 #define THICKNESS_SETTING	"Thickness"
 #define X_OFFSET_SETTING	"X-offset"
 #define Y_OFFSET_SETTING	"Y-offset"
+#define SPREAD_SETTING		"DynamicSpread"
 
 // hotkey IDs
 #define HOTKEY_EXIT					1000						// hotkey ID for exiting the crosshairs app
@@ -69,18 +78,63 @@ using namespace Gdiplus;
 #define HOTKEY_CENTER				1014						// hotkey ID for centering the crosshairs
 #define HOTKEY_LOAD_SETTINGS		1015						// hotkey ID for loading settings from the Windows registry
 #define HOTKEY_SAVE_SETTINGS		1016						// hotkey ID for saving settings from the Windows registry
+#define HOTKEY_TOGGLE_SPREAD		1017						// hotkey ID for enabling/disabling the dynamic crosshairs spread
+
+// timer IDs
+#define TIMER_SPREAD				1							// timer ID for updating the dynamic crosshairs spread
 
 // crosshairs constants
-#define MAX_CROSSHAIRS_SIZE		100								// max. crosshairs size in pixels
 #define MAX_PEN_WIDTH			4								// max. pen width for drawing the crosshairs
 #define DELAY_OVERLAY_UPDATE	1000							// time interval in milliseconds for updating the overlay window
 
+// dynamic spread constants
+#define DELAY_SPREAD_UPDATE		10								// time interval in milliseconds for updating the dynamic spread
+#define DELAY_INPUT_STARTUP		1000							// max. time in milliseconds for starting the raw input thread
+#define DELAY_INPUT_RETRY		10								// time interval in milliseconds for retrying to stop the raw input thread
+
+/*
+ * TYPES
+ */
+
+// pen and brush for rasterizing the tiles
+struct TileStyle {
+	Pen *pen;													// pen for outlines
+	SolidBrush *brush;											// brush for filled shapes
+};
+
+// DIB section for transferring the crosshairs to the layered window
+struct Surface {
+	int32_t width;												// width in pixels
+	int32_t height;												// height in pixels
+	HDC hdc;													// memory DC with the selected DIB section
+	HBITMAP hBitmap;											// DIB section (32 bpp, premultiplied alpha, top-down)
+	HBITMAP hOldBitmap;											// bitmap previously selected into the memory DC
+	uint32_t *pixels;											// pixels of the DIB section
+};
+
 /*
  * FUNCTION PROTOTYPES
  */
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);  
+LRESULT CALLBACK InputWndProc(HWND, UINT, WPARAM, LPARAM);
 DWORD WINAPI UpdateOverlay(LPVOID lpParam);
+DWORD WINAPI ReadMouseInput(LPVOID lpParam);
+bool StartMouseInput();
+void StopMouseInput();
+void StartSpread(HWND hwnd);
+void StopSpread(HWND hwnd);
+void UpdateSpread(HWND hwnd);
 void DrawOverlay(HWND hwnd);
+void RenderTile(void *context, uint32_t *pixels, const TileRect &rect, const Reticle &reticle, const std::vector<uint32_t> &primitives);
+void UploadOverlay(HWND hwnd, bool fullUpdate);
+bool CreateSurface(Surface &surface, int32_t width, int32_t height);
+void DestroySurface(Surface &surface);
+bool CreateFrameExport();
+void ReportError(const TCHAR *feature, const TCHAR *message);
+void DestroyFrameExport();
+uint32_t *BeginExportFrame(int32_t tileCount);
+void PublishFrame(bool fullUpdate);
+int32_t GetSizeStep();
 void LoadSettings();
 void SaveSettings();
 
@@ -91,13 +145,44 @@ HINSTANCE hInst;												// application instance handle
 
 // crosshairs parameters
 int8_t penWidth = 1;											// pen width
-int8_t crosshairsSize = 16;										// size of crosshairs
+int32_t crosshairsSize = 16;									// size of crosshairs
+int32_t max_crosshairs_size = 0;								// max. size of crosshairs
 int32_t x_offset = 0;											// crosshairs X offset from screen center
 int32_t y_offset = 0;											// crosshairs Y offset from screen center
 int32_t max_x_offset = 0;										// max. x offset
 int32_t max_y_offset = 0;										// max. y offset
 bool crosshairsVisible = true;									// flag for crosshairs visibility
 
+// dynamic spread parameters
+bool spreadEnabled = false;										// flag for dynamic crosshairs spread
+SpreadFilter spreadFilter = {};									// filtered spread
+int32_t crosshairsSpread = 0;									// quantized additional crosshairs gap in pixels
+LARGE_INTEGER lastSpreadUpdate;									// performance counter value of the last spread update
+InputQueue inputQueue = {};										// raw mouse movements from the input thread
+HANDLE hInputThread = NULL;										// thread reading raw mouse input, only running while the spread is enabled
+DWORD inputThreadId = 0;										// ID of the raw input thread
+
+// overlay tiles
+TileStore tileStore = {};										// pixels of the tiles containing geometry
+TileBins tileBins = {};											// primitives of the crosshairs binned into tiles
+TileMask shownTiles = {};										// tiles containing geometry of the current frame
+TileMask dirtyTiles = {};										// tiles changed by the current frame
+int8_t tileColor = -1;											// color the tiles were rasterized with
+int8_t tilePenWidth = 0;										// pen width the tiles were rasterized with
+Surface staging = {};											// DIB section covering the tiles containing geometry
+TileRect windowBounds = {};										// screen area covered by the layered window
+
+// frame export
+int64_t frameCounter = 0;										// number of rendered frames
+HANDLE hFrameMapping = NULL;									// shared memory for exporting the rendered frames
+OverlayExportHeader *frameHeader = NULL;						// header of the shared memory, NULL if not exported (only written)
+uint32_t *exportTiles[OVERLAY_EXPORT_SLOTS] = {};				// tile pixels of each shared frame
+int32_t exportSequences[OVERLAY_EXPORT_SLOTS] = {};				// sequence of each shared frame
+int32_t committedTiles[OVERLAY_EXPORT_SLOTS] = {};				// number of tiles with committed pages per shared frame
+int32_t latestSlot = 0;											// shared frame published last
+int32_t writtenSlot = -1;										// shared frame being written, -1 if none
+bool exportSizeExceeded = false;								// flag for a screen larger than the shared frames
+
 // defined colors
 COLORREF TRANSPARENT_COLOR = RGB(0, 0, 0);						// set transparent color
 Color COLORS[] = {												// defined crosshairs colors
@@ -112,7 +197,7 @@ Color COLORS[] = {												// defined crosshairs colors
 };
 uint8_t numColors = sizeof(COLORS) / sizeof(Color);				// number of available colors
 int8_t currentColor = 0;										// currently used color (zero-indexed)
-uint8_t numShapes = 15;											// number of crosshairs shapes
+uint8_t numShapes = NUM_SHAPES;									// number of crosshairs shapes
 int8_t currentShape = 0;										// currently used crosshairs shape (zero-indexed)
  
 /*
@@ -159,6 +244,17 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 		return MessageBox(NULL, TEXT("Could not register the window class!"), TEXT("Error"), MB_ICONERROR | MB_OK);  
 	}
 
+	// define and register window class for the message-only window receiving raw mouse input
+	WNDCLASSEX wcexInput = {};
+	wcexInput.cbSize = sizeof(WNDCLASSEX);
+	wcexInput.lpfnWndProc = InputWndProc;
+	wcexInput.hInstance = hInst;
+	wcexInput.lpszClassName = TEXT(INPUT_CLASSNAME);
+
+	if (!RegisterClassEx(&wcexInput)) {
+		return MessageBox(NULL, TEXT("Could not register the input window class!"), TEXT("Error"), MB_ICONERROR | MB_OK);  
+	}
+
 	// create window
 	HWND hWnd = CreateWindowEx(
 		WS_EX_TRANSPARENT | WS_EX_TOPMOST | WS_EX_LAYERED,
@@ -197,11 +293,15 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 	RegisterHotKey(hWnd, HOTKEY_DECREASE_THICKNESS, MOD_CONTROL, VK_F8);
 	RegisterHotKey(hWnd, HOTKEY_LOAD_SETTINGS, 0, VK_F10);
 	RegisterHotKey(hWnd, HOTKEY_SAVE_SETTINGS, 0, VK_F11);
+	RegisterHotKey(hWnd, HOTKEY_TOGGLE_SPREAD, MOD_CONTROL, VK_F1);
 
 	// set max x and y offsets	
 	max_x_offset = GetSystemMetrics(SM_CXSCREEN) / 2;
 	max_y_offset = GetSystemMetrics(SM_CYSCREEN) / 2;
 
+	// set max. crosshairs size, allowing lines spanning the whole screen
+	max_crosshairs_size = GetSystemMetrics(SM_CXSCREEN) > GetSystemMetrics(SM_CYSCREEN) ? GetSystemMetrics(SM_CXSCREEN) : GetSystemMetrics(SM_CYSCREEN);
+
 	// load settings from Windows registry
 	HKEY hKey;
 	DWORD dwError;
@@ -231,6 +331,9 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 
 			dwValue = y_offset;
 			RegSetValueEx(hKey, TEXT(Y_OFFSET_SETTING), 0, REG_DWORD, (const BYTE*)&dwValue, sizeof(dwValue));
+
+			dwValue = spreadEnabled;
+			RegSetValueEx(hKey, TEXT(SPREAD_SETTING), 0, REG_DWORD, (const BYTE*)&dwValue, sizeof(dwValue));
 		} else {
 			// load existing settings from Windows registry
 			LoadSettings();
@@ -238,12 +341,20 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 		RegCloseKey(hKey);
 	}
 
+	// create shared memory for exporting the rendered frames
+	CreateFrameExport();
+
 	// draw the crosshairs overlay
 	DrawOverlay(hWnd);
 
 	// create thread for periodically updating the overlay window
 	CreateThread(NULL, 0, UpdateOverlay, hWnd, 0, 0);
 
+	// start reading raw mouse input if the dynamic spread is enabled
+	if (spreadEnabled) {
+		StartSpread(hWnd);
+	}
+
 	// show window
 	ShowWindow(hWnd, SW_SHOW);  
 	UpdateWindow(hWnd);  
@@ -254,7 +365,10 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 		DispatchMessage(&msg);  
 	}  
 
-	// cleanup GDI+
+	// cleanup overlay tiles, shared frames and GDI+
+	DestroySurface(staging);
+	FreeTileStore(tileStore);
+	DestroyFrameExport();
 	GdiplusShutdown(gdiplusToken);
 
 	return (int)msg.wParam;  
@@ -276,9 +390,16 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 			break;  
 
 		case WM_DESTROY:
+			StopMouseInput();
 			PostQuitMessage(0);
 			return 0;
 
+		case WM_TIMER:
+			if (wParam == TIMER_SPREAD) {
+				UpdateSpread(hWnd);
+			}
+			break;
+
 		case WM_HOTKEY:
 			switch (wParam) {
 				case HOTKEY_EXIT:
@@ -291,15 +412,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 					break;
 
 				case HOTKEY_INCREASE_SIZE:
-					crosshairsSize += 2;
-					if (crosshairsSize > MAX_CROSSHAIRS_SIZE) {
-						crosshairsSize = MAX_CROSSHAIRS_SIZE;
+					crosshairsSize += GetSizeStep();
+					if (crosshairsSize > max_crosshairs_size) {
+						crosshairsSize = max_crosshairs_size;
 					}
 					DrawOverlay(hWnd);
 					break;
 
 				case HOTKEY_DECREASE_SIZE:
-					crosshairsSize -= 2;
+					crosshairsSize -= GetSizeStep();
 					if (crosshairsSize < 1) {
 						crosshairsSize = 1;
 					}
@@ -399,6 +520,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 
 				case HOTKEY_LOAD_SETTINGS:
 					LoadSettings();
+					if (spreadEnabled) {
+						StartSpread(hWnd);
+					} else {
+						StopSpread(hWnd);
+					}
 					DrawOverlay(hWnd);
 					break;
 
@@ -406,6 +532,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 					SaveSettings();
 					DrawOverlay(hWnd);
 					break;
+
+				case HOTKEY_TOGGLE_SPREAD:
+					if (spreadEnabled) {
+						StopSpread(hWnd);
+					} else {
+						StartSpread(hWnd);
+					}
+					DrawOverlay(hWnd);
+					break;
 			}
 			break;  
 
@@ -446,6 +581,186 @@ DWORD WINAPI UpdateOverlay(LPVOID lpParam) {
     return 0;
 }
 
+/*
+ * Read raw mouse input on its own thread and queue it for the dynamic spread
+ */
+DWORD WINAPI ReadMouseInput(LPVOID lpParam) {
+	HANDLE hReady = (HANDLE)lpParam;
+	MSG msg;
+
+	// create message-only window receiving the raw input
+	// (failures end the thread, its exit code is the error code)
+	HWND hWnd = CreateWindowEx(0, TEXT(INPUT_CLASSNAME), NULL, 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, hInst, NULL);
+	if (!hWnd) {
+		return GetLastError();
+	}
+
+	// register for raw mouse input, also when not in the foreground
+	RAWINPUTDEVICE rid = {};
+	rid.usUsagePage = 0x01;										// HID_USAGE_PAGE_GENERIC
+	rid.usUsage = 0x02;											// HID_USAGE_GENERIC_MOUSE
+	rid.dwFlags = RIDEV_INPUTSINK;
+	rid.hwndTarget = hWnd;
+
+	if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
+		DWORD dwError = GetLastError();
+		DestroyWindow(hWnd);
+		return dwError;
+	}
+	SetEvent(hReady);
+
+	// message loop, ends with WM_QUIT posted by StopMouseInput
+	while (GetMessage(&msg, NULL, 0, 0)) {
+		DispatchMessage(&msg);
+	}
+
+	// stop receiving raw mouse input
+	rid.dwFlags = RIDEV_REMOVE;
+	rid.hwndTarget = NULL;
+	RegisterRawInputDevices(&rid, 1, sizeof(rid));
+	DestroyWindow(hWnd);
+	return 0;
+}
+
+/*
+ * Window procedure of the message-only window receiving raw mouse input
+ */
+LRESULT CALLBACK InputWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+	switch (message) {
+		case WM_INPUT: {
+			RAWINPUT raw;
+			UINT size = sizeof(raw);
+
+			// only relative mouse movements are relevant for the spread
+			if ((GetRawInputData((HRAWINPUT)lParam, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1) &&
+				(raw.header.dwType == RIM_TYPEMOUSE) &&
+				!(raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) &&
+				(raw.data.mouse.lLastX != 0 || raw.data.mouse.lLastY != 0)) {
+				MouseMove move = {(int32_t)raw.data.mouse.lLastX, (int32_t)raw.data.mouse.lLastY};
+
+				// movements are dropped if the UI thread falls behind
+				PushMouseMove(inputQueue, move);
+			}
+			break;
+		}
+	}
+	return DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+/*
+ * Start the raw input thread and wait until it receives raw mouse input
+ */
+bool StartMouseInput() {
+	HANDLE hReady = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (!hReady) {
+		ReportError(TEXT("dynamic spread"), TEXT("could not create the startup event"));
+		return false;
+	}
+
+	hInputThread = CreateThread(NULL, 0, ReadMouseInput, hReady, 0, &inputThreadId);
+	if (!hInputThread) {
+		ReportError(TEXT("dynamic spread"), TEXT("could not create the raw input thread"));
+		CloseHandle(hReady);
+		return false;
+	}
+
+	// the thread either signals the event, or exits if it fails
+	HANDLE handles[2] = {hReady, hInputThread};
+	DWORD dwResult = WaitForMultipleObjects(2, handles, FALSE, DELAY_INPUT_STARTUP);
+	if (dwResult != WAIT_OBJECT_0) {
+		DWORD dwExitCode = ERROR_TIMEOUT;
+		if (dwResult == WAIT_OBJECT_0 + 1) {
+			GetExitCodeThread(hInputThread, &dwExitCode);
+		}
+
+		// the event is closed after the thread has exited, it may still signal it
+		StopMouseInput();
+		CloseHandle(hReady);
+		SetLastError(dwExitCode);
+		ReportError(TEXT("dynamic spread"), (dwExitCode == ERROR_TIMEOUT) ?
+			TEXT("the raw input thread did not start in time") : TEXT("could not register for raw mouse input"));
+		return false;
+	}
+
+	CloseHandle(hReady);
+	return true;
+}
+
+/*
+ * Stop the raw input thread and wait for it to exit
+ */
+void StopMouseInput() {
+	if (!hInputThread) {
+		return;
+	}
+
+	// end the message loop, posting fails until the thread has created its message queue
+	do {
+		PostThreadMessage(inputThreadId, WM_QUIT, 0, 0);
+	} while (WaitForSingleObject(hInputThread, DELAY_INPUT_RETRY) == WAIT_TIMEOUT);
+
+	CloseHandle(hInputThread);
+	hInputThread = NULL;
+	inputThreadId = 0;
+}
+
+/*
+ * Enable the dynamic crosshairs spread, it stays disabled if raw mouse input is not available
+ */
+void StartSpread(HWND hwnd) {
+	// start the raw input thread, it only receives mouse input while the spread is enabled
+	if (!hInputThread && !StartMouseInput()) {
+		KillTimer(hwnd, TIMER_SPREAD);
+		spreadEnabled = false;
+		ResetSpread(spreadFilter);
+		crosshairsSpread = 0;
+		return;
+	}
+
+	// discard mouse movements queued before
+	DrainMouseMoves(inputQueue);
+
+	spreadEnabled = true;
+	ResetSpread(spreadFilter);
+	crosshairsSpread = 0;
+	QueryPerformanceCounter(&lastSpreadUpdate);
+	SetTimer(hwnd, TIMER_SPREAD, DELAY_SPREAD_UPDATE, NULL);
+}
+
+/*
+ * Disable the dynamic crosshairs spread
+ */
+void StopSpread(HWND hwnd) {
+	KillTimer(hwnd, TIMER_SPREAD);
+	StopMouseInput();
+	spreadEnabled = false;
+	ResetSpread(spreadFilter);
+	crosshairsSpread = 0;
+}
+
+/*
+ * Update the dynamic crosshairs spread from the queued mouse movements
+ */
+void UpdateSpread(HWND hwnd) {
+	LARGE_INTEGER now;
+	LARGE_INTEGER frequency;
+
+	// sum up the distance moved since the last update
+	double distance = DrainMouseMoves(inputQueue);
+
+	// calculate elapsed time in milliseconds
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&frequency);
+	double elapsed = (double)(now.QuadPart - lastSpreadUpdate.QuadPart) * 1000.0 / frequency.QuadPart;
+	lastSpreadUpdate = now;
+
+	// only redraw if the quantized gap has changed
+	if (StepSpread(spreadFilter, distance, elapsed)) {
+		crosshairsSpread = spreadFilter.gap;
+		DrawOverlay(hwnd);
+	}
+}
+
 /*
  * Draw crosshairs on overlay window
  */
@@ -456,163 +771,382 @@ void DrawOverlay(HWND hwnd) {
 	int32_t centerX = (screenWidth / 2) + x_offset;
 	int32_t centerY = (screenHeight / 2) + y_offset;
 
-    // create a memory DC
-    HDC hdcScreen = GetDC(NULL);
-    HDC hdcMem = CreateCompatibleDC(hdcScreen);
+	// (re)create the tiles if the screen size has changed
+	bool fullUpdate = false;
+	if ((tileStore.grid.width != screenWidth) || (tileStore.grid.height != screenHeight)) {
+		FreeTileStore(tileStore);
+		InitTileStore(tileStore, screenWidth, screenHeight);
+		InitTileBins(tileBins, tileStore.grid);
+		InitTileMask(shownTiles, tileStore.grid);
+		InitTileMask(dirtyTiles, tileStore.grid);
+		fullUpdate = true;
+	}
 
-    // create a compatible bitmap for the memory DC
-    HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, screenWidth, screenHeight);
-    HBITMAP hOldBitmap = (HBITMAP)SelectObject(hdcMem, hBitmap);
+	// collect the geometry of the crosshairs
+	Reticle reticle = {};
+	if (crosshairsVisible) {
+		BuildReticle(reticle, currentShape, centerX, centerY, crosshairsSize, penWidth, crosshairsSpread);
+	}
 
-	Graphics graphics(hdcMem);
-	// graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
+	// bin the primitives into the tiles they touch, padded by half the pen width plus some pixels for antialiasing
+	BinPrimitives(tileStore.grid, reticle, (float)penWidth / 2 + 2, tileBins);
 
-	// draw crosshairs
-	if (crosshairsVisible) {
-		// draw the crosshairs
-		int sideLength = crosshairsSize / 2;
-
-		// create pen
-		Pen pen(COLORS[currentColor], penWidth);
-		pen.SetAlignment(PenAlignmentCenter);
-
-		// create brush
-		SolidBrush brush(COLORS[currentColor]);
-
-		// draw selected crosshairs shape
-		switch (currentShape) {
-			case 0:
-				// cross
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY + crosshairsSize);
-				break;
+	// render the tiles directly into the next shared frame if the frames are exported
+	int32_t tileCount = (int32_t)tileBins.inked.marked.size();
+	SetTileMemory(tileStore, BeginExportFrame(tileCount), tileCount);
 
-			case 1:
-				// cross with small gap in the center
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - penWidth, centerY);
-				graphics.DrawLine(&pen, centerX + penWidth, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - penWidth);
-				graphics.DrawLine(&pen, centerX, centerY + penWidth, centerX, centerY + crosshairsSize);
-				break;
+	// create pen
+	Pen pen(COLORS[currentColor], penWidth);
+	pen.SetAlignment(PenAlignmentCenter);
 
-			case 2:
-				// cross with a large gap in the center
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - sideLength, centerY);
-				graphics.DrawLine(&pen, centerX + sideLength, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - sideLength);
-				graphics.DrawLine(&pen, centerX, centerY + sideLength, centerX, centerY + crosshairsSize);
-				break;
+	// create brush
+	SolidBrush brush(COLORS[currentColor]);
 
-			case 3:
-				// cross with a small gap in the center
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - sideLength * (0.75), centerY);
-				graphics.DrawLine(&pen, centerX + sideLength * (0.75), centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - sideLength * (0.75));
-				graphics.DrawLine(&pen, centerX, centerY + sideLength * (0.75), centerX, centerY + crosshairsSize);
-				break;
+	// only store the tiles containing geometry, and only rasterize the changed ones (all of them for a different pen or a shared frame)
+	bool redraw = fullUpdate || (tileColor != currentColor) || (tilePenWidth != penWidth);
+	TileStyle style = {&pen, &brush};
+	UpdateTiles(tileStore, tileBins, reticle, redraw, RenderTile, &style, shownTiles, dirtyTiles);
+	tileColor = currentColor;
+	tilePenWidth = penWidth;
 
-			case 4:
-				// cross with a small gap in the center
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - sideLength / 2, centerY);
-				graphics.DrawLine(&pen, centerX + sideLength / 2, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - sideLength / 2);
-				graphics.DrawLine(&pen, centerX, centerY + sideLength / 2, centerX, centerY + crosshairsSize);
-				break;
+	// publish the frame to external consumers
+	PublishFrame(fullUpdate);
 
-			case 5:
-				// cross with a large gap in the center and a center dot
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - sideLength, centerY);
-				graphics.DrawLine(&pen, centerX + sideLength, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - sideLength);
-				graphics.DrawLine(&pen, centerX, centerY + sideLength, centerX, centerY + crosshairsSize);
-				graphics.FillRectangle(&brush, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
-				break;
+	// transfer the crosshairs to the layered window
+	UploadOverlay(hwnd, fullUpdate);
+}
 
-			case 6:
-				// cross with a medium gap in the center and center dot
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - sideLength * 0.75, centerY);
-				graphics.DrawLine(&pen, centerX + sideLength * 0.75, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - sideLength * 0.75);
-				graphics.DrawLine(&pen, centerX, centerY + sideLength * 0.75, centerX, centerY + crosshairsSize);
-				graphics.FillRectangle(&brush, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+/*
+ * Rasterize the primitives touching a tile with the pen and brush given as context
+ */
+void RenderTile(void *context, uint32_t *pixels, const TileRect &rect, const Reticle &reticle, const std::vector<uint32_t> &primitives) {
+	TileStyle *style = (TileStyle*)context;
+
+	// draw directly to the tile pixels, in screen coordinates, pixels of edge tiles beyond the screen stay transparent
+	Bitmap bitmap(TILE_SIZE, TILE_SIZE, TILE_SIZE * sizeof(uint32_t), PixelFormat32bppPARGB, (BYTE*)pixels);
+	Graphics graphics(&bitmap);
+	graphics.SetClip(Rect(0, 0, rect.right - rect.left, rect.bottom - rect.top));
+	graphics.TranslateTransform((REAL)-rect.left, (REAL)-rect.top);
+
+	for (uint32_t i : primitives) {
+		const Primitive &p = reticle.primitives[i];
+		graphics.SetSmoothingMode(p.antiAlias ? SmoothingMode::SmoothingModeAntiAlias : SmoothingMode::SmoothingModeDefault);
+
+		switch (p.type) {
+			case PRIMITIVE_LINE:
+				graphics.DrawLine(style->pen, p.x1, p.y1, p.x2, p.y2);
 				break;
 
-			case 7:
-				// cross with a small gap in the center and center dot
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX - sideLength / 2, centerY);
-				graphics.DrawLine(&pen, centerX + sideLength / 2, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY - sideLength / 2);
-				graphics.DrawLine(&pen, centerX, centerY + sideLength / 2, centerX, centerY + crosshairsSize);
-				graphics.FillRectangle(&brush, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			case PRIMITIVE_ELLIPSE:
+				graphics.DrawEllipse(style->pen, p.x1, p.y1, p.x2, p.y2);
 				break;
 
-			case 8:
-				// circle with a center dot
-				graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
-				graphics.DrawEllipse(&pen, centerX - crosshairsSize, centerY - crosshairsSize, 2 * crosshairsSize, 2 * crosshairsSize);
-				graphics.FillRectangle(&brush, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			case PRIMITIVE_RECTANGLE:
+				graphics.DrawRectangle(style->pen, p.x1, p.y1, p.x2, p.y2);
 				break;
 
-			case 9:
-				// circle with a small center cross
-				graphics.DrawLine(&pen, centerX - crosshairsSize / 4, centerY, centerX + crosshairsSize / 4, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize / 4, centerX, centerY + crosshairsSize / 4);
-				graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
-				graphics.DrawEllipse(&pen, centerX - crosshairsSize, centerY - crosshairsSize, 2 * crosshairsSize, 2 * crosshairsSize);
+			case PRIMITIVE_FILLED_RECTANGLE:
+				graphics.FillRectangle(style->brush, p.x1, p.y1, p.x2, p.y2);
 				break;
+		}
+	}
+}
 
-			case 10:
-				// center dot
-				graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
-				graphics.FillRectangle(&brush, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
-				break;
+/*
+ * Transfer the tiles containing geometry to the layered window
+ */
+void UploadOverlay(HWND hwnd, bool fullUpdate) {
+	// the layered window only covers the tiles containing geometry, or a single transparent pixel
+	TileRect bounds = GetTileBounds(tileStore.grid, shownTiles);
+	if ((bounds.right <= bounds.left) || (bounds.bottom <= bounds.top)) {
+		bounds.left = 0;
+		bounds.top = 0;
+		bounds.right = 1;
+		bounds.bottom = 1;
+	}
+	int32_t width = bounds.right - bounds.left;
+	int32_t height = bounds.bottom - bounds.top;
+
+	// (re)create the DIB section if it is too small or much too large
+	bool recompose = fullUpdate || (memcmp(&bounds, &windowBounds, sizeof(TileRect)) != 0);
+	if (!staging.hdc || (width > staging.width) || (height > staging.height) || ((int64_t)width * height * 4 < (int64_t)staging.width * staging.height)) {
+		DestroySurface(staging);
+		if (!CreateSurface(staging, width, height)) {
+			return;
+		}
+		recompose = true;
+	}
 
-			case 11:
-				// cross with large circle
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY + crosshairsSize);
-				graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
-				graphics.DrawEllipse(&pen, centerX - crosshairsSize, centerY - crosshairsSize,  2 * crosshairsSize, 2 * crosshairsSize);
-				break;
+	// area of the window to update, relative to the window
+	RECT rcDirty = {0, 0, width, height};
+	if (recompose) {
+		ComposeTiles(tileStore, bounds, staging.pixels, staging.width, bounds.left, bounds.top);
+	} else {
+		// same area as before, only copy the changed tiles
+		if (dirtyTiles.marked.empty()) {
+			return;
+		}
+		for (int32_t index : dirtyTiles.marked) {
+			ComposeTiles(tileStore, GetTileRect(tileStore.grid, index), staging.pixels, staging.width, bounds.left, bounds.top);
+		}
 
-			case 12:
-				// cross with medium circle
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY + crosshairsSize);
-				graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
-				graphics.DrawEllipse(&pen, centerX - crosshairsSize / 2, centerY - crosshairsSize / 2, crosshairsSize, crosshairsSize);
-				break;
+		TileRect dirty = GetTileBounds(tileStore.grid, dirtyTiles);
+		rcDirty.left = ((dirty.left > bounds.left) ? dirty.left : bounds.left) - bounds.left;
+		rcDirty.top = ((dirty.top > bounds.top) ? dirty.top : bounds.top) - bounds.top;
+		rcDirty.right = ((dirty.right < bounds.right) ? dirty.right : bounds.right) - bounds.left;
+		rcDirty.bottom = ((dirty.bottom < bounds.bottom) ? dirty.bottom : bounds.bottom) - bounds.top;
+	}
+	windowBounds = bounds;
+
+	// use a single UpdateLayeredWindowIndirect per frame, so the crosshairs are never shown partially updated,
+	// only copying the changed area if the window has not been moved or resized
+	POINT ptPos = {bounds.left, bounds.top};
+	SIZE sizeWnd = {width, height};
+	POINT ptSrc = {0, 0};
+	BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+	HDC hdcWindow = GetDC(hwnd);
+
+	UPDATELAYEREDWINDOWINFO info = {};
+	info.cbSize = sizeof(info);
+	info.hdcDst = hdcWindow;
+	info.pptDst = &ptPos;
+	info.psize = &sizeWnd;
+	info.hdcSrc = staging.hdc;
+	info.pptSrc = &ptSrc;
+	info.crKey = TRANSPARENT_COLOR;
+	info.pblend = &blend;
+	info.dwFlags = ULW_ALPHA;
+	info.prcDirty = recompose ? NULL : &rcDirty;
+	UpdateLayeredWindowIndirect(hwnd, &info);
+	ReleaseDC(hwnd, hdcWindow);
+}
 
-			case 13:
-				// cross with medium rectangle
-				graphics.DrawLine(&pen, centerX - crosshairsSize, centerY, centerX + crosshairsSize, centerY);
-				graphics.DrawLine(&pen, centerX, centerY - crosshairsSize, centerX, centerY + crosshairsSize);
-				graphics.DrawRectangle(&pen, centerX - crosshairsSize / 2, centerY - crosshairsSize / 2, crosshairsSize, crosshairsSize);
-				break;
+/*
+ * Create DIB section
+ */
+bool CreateSurface(Surface &surface, int32_t width, int32_t height) {
+	// 32 bpp top-down DIB section
+	BITMAPINFO bmi = {};
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = width;
+	bmi.bmiHeader.biHeight = -height;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	// create a memory DC
+	HDC hdcScreen = GetDC(NULL);
+	surface.hdc = CreateCompatibleDC(hdcScreen);
+	ReleaseDC(NULL, hdcScreen);
+
+	surface.hBitmap = CreateDIBSection(surface.hdc, &bmi, DIB_RGB_COLORS, (void**)&surface.pixels, NULL, 0);
+	if (!surface.hBitmap) {
+		DeleteDC(surface.hdc);
+		surface = Surface();
+		return false;
+	}
+	surface.hOldBitmap = (HBITMAP)SelectObject(surface.hdc, surface.hBitmap);
 
-			case 14:
-				// circle with one lower vertical line
-				graphics.DrawLine(&pen, centerX, centerY, centerX, centerY + crosshairsSize);
-				graphics.SetSmoothingMode(SmoothingMode::SmoothingModeAntiAlias);
-				graphics.DrawEllipse(&pen, centerX - crosshairsSize, centerY - crosshairsSize, 2 * crosshairsSize, 2 * crosshairsSize);
-				break;
+	surface.width = width;
+	surface.height = height;
+	return true;
+}
+
+/*
+ * Destroy DIB section
+ */
+void DestroySurface(Surface &surface) {
+	if (surface.hdc) {
+		SelectObject(surface.hdc, surface.hOldBitmap);
+		DeleteObject(surface.hBitmap);
+		DeleteDC(surface.hdc);
+	}
+	surface = Surface();
+}
+
+/*
+ * Create shared memory for exporting the rendered frames
+ */
+bool CreateFrameExport() {
+	uint64_t headerSize = (sizeof(OverlayExportHeader) + 4095) & ~(uint64_t)4095;
+	uint64_t frameSize = (uint64_t)OVERLAY_EXPORT_MAX_TILES * OVERLAY_EXPORT_TILE_BYTES;
+	uint64_t mappingSize = headerSize + OVERLAY_EXPORT_SLOTS * frameSize;
+
+	// reserve the named file mapping for the max. screen size, pages are only committed when tiles are stored
+	hFrameMapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE | SEC_RESERVE, (DWORD)(mappingSize >> 32), (DWORD)mappingSize, TEXT(OVERLAY_EXPORT_NAME));
+	if (!hFrameMapping) {
+		ReportError(TEXT("frame export"), TEXT("could not create the shared memory"));
+		return false;
+	}
+
+	// map the shared memory and commit the header
+	void *view = MapViewOfFile(hFrameMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!view || !VirtualAlloc(view, headerSize, MEM_COMMIT, PAGE_READWRITE)) {
+		ReportError(TEXT("frame export"), TEXT("could not map the shared memory"));
+		if (view) {
+			UnmapViewOfFile(view);
 		}
+		CloseHandle(hFrameMapping);
+		hFrameMapping = NULL;
+		return false;
 	}
+	frameHeader = (OverlayExportHeader*)view;
+
+	// a mapping reused from a previous instance may contain old frames, which are dropped by resetting the slots
+	frameHeader->magic = 0;
+	frameHeader->version = OVERLAY_EXPORT_VERSION;
+	frameHeader->slotCount = OVERLAY_EXPORT_SLOTS;
+	frameHeader->tileSize = OVERLAY_EXPORT_TILE_SIZE;
+	frameHeader->frame = 0;
+	frameHeader->latestSlot = 0;
+
+	for (uint32_t slot = 0; slot < OVERLAY_EXPORT_SLOTS; slot++) {
+		OverlayExportSlot &exportSlot = frameHeader->slots[slot];
+		exportSlot.sequence = 0;
+		exportSlot.tileCount = 0;
+		exportSlot.frame = 0;
+		exportSlot.width = 0;
+		exportSlot.height = 0;
+		exportSlot.dirtyLeft = 0;
+		exportSlot.dirtyTop = 0;
+		exportSlot.dirtyRight = 0;
+		exportSlot.dirtyBottom = 0;
+		exportSlot.offset = headerSize + slot * frameSize;
+
+		// the producer only uses its private copies
+		exportTiles[slot] = (uint32_t*)((uint8_t*)view + headerSize + slot * frameSize);
+		exportSequences[slot] = 0;
+		committedTiles[slot] = 0;
+	}
+	latestSlot = 0;
+	writtenSlot = -1;
 
-    // use UpdateLayeredWindow to transfer the bitmap to the layered window
-    POINT ptPos = {0, 0};
-    SIZE sizeWnd = {screenWidth, screenHeight};
-    POINT ptSrc = {0, 0};
-    BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
-    HDC hdcWindow = GetDC(hwnd);
-    UpdateLayeredWindow(hwnd, hdcWindow, &ptPos, &sizeWnd, hdcMem, &ptSrc, TRANSPARENT_COLOR, &blend, ULW_ALPHA);
-
-    // cleanup
-    SelectObject(hdcMem, hOldBitmap);
-    DeleteObject(hBitmap);
-    DeleteDC(hdcMem);
-    ReleaseDC(NULL, hdcScreen);
-    ReleaseDC(hwnd, hdcWindow);
+	// announce the frames to consumers
+	__atomic_store_n(&frameHeader->magic, OVERLAY_EXPORT_MAGIC, __ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+ * Destroy shared memory
+ */
+void DestroyFrameExport() {
+	if (frameHeader) {
+		// tell consumers to re-open the shared memory
+		__atomic_store_n(&frameHeader->magic, 0, __ATOMIC_RELEASE);
+		UnmapViewOfFile(frameHeader);
+		frameHeader = NULL;
+	}
+	writtenSlot = -1;
+
+	if (hFrameMapping) {
+		CloseHandle(hFrameMapping);
+		hFrameMapping = NULL;
+	}
+}
+
+/*
+ * Report why a feature is disabled (shown by debuggers and tools like DebugView)
+ */
+void ReportError(const TCHAR *feature, const TCHAR *message) {
+	DWORD dwError = GetLastError();
+	TCHAR error[32];
+	wsprintf(error, TEXT(" (error %lu)\n"), dwError);
+
+	OutputDebugString(TEXT(APPNAME ": "));
+	OutputDebugString(feature);
+	OutputDebugString(TEXT(" disabled, "));
+	OutputDebugString(message);
+	OutputDebugString(error);
+}
+
+/*
+ * Start writing the shared frame after the latest one, returns the memory for its tiles, or NULL if the frames are
+ * not exported
+ */
+uint32_t *BeginExportFrame(int32_t tileCount) {
+	writtenSlot = -1;
+	if (!frameHeader) {
+		return NULL;
+	}
+
+	const TileGrid &grid = tileStore.grid;
+	if ((grid.width > OVERLAY_EXPORT_MAX_WIDTH) || (grid.height > OVERLAY_EXPORT_MAX_HEIGHT)) {
+		if (!exportSizeExceeded) {
+			ReportError(TEXT("frame export"), TEXT("screen larger than the shared frames"));
+			exportSizeExceeded = true;
+		}
+		return NULL;
+	}
+	exportSizeExceeded = false;
+
+	// the two most recently published frames may still be read by consumers
+	int32_t slot = (latestSlot + 1) % OVERLAY_EXPORT_SLOTS;
+
+	// commit the pages for the tiles beyond the largest frame stored in this slot so far
+	if (tileCount > committedTiles[slot]) {
+		uint8_t *start = (uint8_t*)exportTiles[slot] + (size_t)committedTiles[slot] * OVERLAY_EXPORT_TILE_BYTES;
+		if (!VirtualAlloc(start, (size_t)(tileCount - committedTiles[slot]) * OVERLAY_EXPORT_TILE_BYTES, MEM_COMMIT, PAGE_READWRITE)) {
+			ReportError(TEXT("frame export"), TEXT("could not commit the shared frame"));
+			DestroyFrameExport();
+			return NULL;
+		}
+		committedTiles[slot] = tileCount;
+	}
+
+	OverlayBeginWrite(&frameHeader->slots[slot], &exportSequences[slot]);
+	writtenSlot = slot;
+	return exportTiles[slot];
+}
+
+/*
+ * Complete the shared frame whose tiles have been rendered, and make it the latest frame
+ */
+void PublishFrame(bool fullUpdate) {
+	frameCounter++;
+
+	if (writtenSlot < 0) {
+		return;
+	}
+
+	// area changed compared to the previous frame
+	const TileGrid &grid = tileStore.grid;
+	TileRect dirtyBounds = GetTileBounds(grid, dirtyTiles);
+	if (fullUpdate) {
+		dirtyBounds.left = 0;
+		dirtyBounds.top = 0;
+		dirtyBounds.right = grid.width;
+		dirtyBounds.bottom = grid.height;
+	}
+
+	// the tiles containing geometry are packed in the order of the shown tiles, all other tiles are transparent
+	OverlayExportSlot &exportSlot = frameHeader->slots[writtenSlot];
+	int32_t tileCount = (int32_t)shownTiles.marked.size();
+	for (int32_t i = 0; i < tileCount; i++) {
+		exportSlot.tiles[i] = (uint16_t)shownTiles.marked[i];
+	}
+	exportSlot.tileCount = tileCount;
+	exportSlot.frame = frameCounter;
+	exportSlot.width = grid.width;
+	exportSlot.height = grid.height;
+	exportSlot.dirtyLeft = dirtyBounds.left;
+	exportSlot.dirtyTop = dirtyBounds.top;
+	exportSlot.dirtyRight = dirtyBounds.right;
+	exportSlot.dirtyBottom = dirtyBounds.bottom;
+
+	OverlayEndWrite(&exportSlot, &exportSequences[writtenSlot]);
+	OverlayPublish(frameHeader, writtenSlot, frameCounter);
+	latestSlot = writtenSlot;
+	writtenSlot = -1;
+}
+
+/*
+ * Get step for changing the crosshairs size, larger crosshairs are resized in larger steps
+ */
+int32_t GetSizeStep() {
+	if (crosshairsSize < 100) {
+		return 2;
+	}
+	return (crosshairsSize / 20) * 2;
 }
 
 /*
@@ -642,8 +1176,8 @@ void LoadSettings() {
 
 		dwSize = 4;
 		RegQueryValueEx(hKey, TEXT(SIZE_SETTING), 0, &dwType, (LPBYTE)&dwValue, &dwSize);
-		crosshairsSize = (int8_t)dwValue;
-		if ((crosshairsSize < 0) || (crosshairsSize >= MAX_CROSSHAIRS_SIZE)) {
+		crosshairsSize = (int32_t)dwValue;
+		if ((crosshairsSize < 1) || (crosshairsSize > max_crosshairs_size)) {
 			crosshairsSize = 10;
 		}
 
@@ -667,6 +1201,11 @@ void LoadSettings() {
 		if ((y_offset < max_y_offset) || (x_offset >= max_y_offset)) {
 			y_offset = 0;
 		}
+
+		dwSize = 4;
+		dwValue = 0;
+		RegQueryValueEx(hKey, TEXT(SPREAD_SETTING), 0, &dwType, (LPBYTE)&dwValue, &dwSize);
+		spreadEnabled = (dwValue != 0);
 	}
 }
 
@@ -697,5 +1236,8 @@ void SaveSettings() {
 
 		dwValue = y_offset;
 		RegSetValueEx(hKey, TEXT(Y_OFFSET_SETTING), 0, REG_DWORD, (const BYTE*)&dwValue, sizeof(dwValue));
+
+		dwValue = spreadEnabled;
+		RegSetValueEx(hKey, TEXT(SPREAD_SETTING), 0, REG_DWORD, (const BYTE*)&dwValue, sizeof(dwValue));
 	}
 }
@@ -0,0 +1,130 @@
+/*
+ * Layout of the crosshairs overlay frames shared with external consumers
+ * (e.g. capture and streaming tools)
+ *
+ * Fadenkreuz publishes the rendered overlay in the named shared memory
+ * OVERLAY_EXPORT_NAME (file mapping). It starts with an OverlayExportHeader,
+ * followed by the tile pixels of OVERLAY_EXPORT_SLOTS frames. The shared
+ * memory is sized for the max. screen size once and never recreated, the
+ * size of each frame is stored in its slot.
+ *
+ * A frame only stores the tiles of OVERLAY_EXPORT_TILE_SIZE x
+ * OVERLAY_EXPORT_TILE_SIZE pixels containing crosshairs, packed one after
+ * another in 32 bpp BGRA with premultiplied alpha, top-down. tiles[i] is the
+ * screen tile (row * tilesX + column, tilesX = ceil(width / tile size)) of
+ * the i-th stored tile, all other tiles are transparent. Pixels of edge tiles
+ * beyond the frame size are transparent. Memory beyond the stored tiles may
+ * not be committed and must not be read.
+ *
+ * Frames are written round-robin, so the two most recently published frames
+ * are never written to. Consumers read a frame as follows:
+ *
+ *   1. check magic and version, re-open the shared memory if they differ
+ *   2. read latestSlot, and the sequence of this slot, retry if it is odd
+ *   3. copy the tiles (and use the size, dirty rectangle and frame counter)
+ *   4. discard the copy if the sequence of the slot has changed meanwhile
+ *
+ * Fadenkreuz renders the tiles directly into the frame being written, and
+ * composes its own window from there. As other processes can write to the
+ * shared memory, the producer never reads from it: the latest slot, the slot
+ * offsets and the sequences are kept in private copies.
+ *
+ * The helper functions below implement the required memory ordering with
+ * GCC builtins (GCC, MinGW, clang).
+ */
+
+#ifndef OVERLAYEXPORT_H
+#define OVERLAYEXPORT_H
+
+#include <stdint.h>
+
+#define OVERLAY_EXPORT_NAME			"Local\\FadenkreuzOverlay.2"	// name of the shared memory, changes with the layout version
+#define OVERLAY_EXPORT_MAGIC		0x4B5A4446					// "FDZK", cleared when the shared memory is abandoned
+#define OVERLAY_EXPORT_VERSION		2							// version of the layout
+#define OVERLAY_EXPORT_SLOTS		3							// number of frames (triple buffer)
+#define OVERLAY_EXPORT_TILE_SIZE	64							// width and height of a tile in pixels
+#define OVERLAY_EXPORT_TILE_BYTES	(OVERLAY_EXPORT_TILE_SIZE * OVERLAY_EXPORT_TILE_SIZE * 4)
+#define OVERLAY_EXPORT_MAX_WIDTH	7680						// max. frame size in pixels (8K)
+#define OVERLAY_EXPORT_MAX_HEIGHT	4320
+#define OVERLAY_EXPORT_MAX_TILES	(((OVERLAY_EXPORT_MAX_WIDTH + OVERLAY_EXPORT_TILE_SIZE - 1) / OVERLAY_EXPORT_TILE_SIZE) * \
+									((OVERLAY_EXPORT_MAX_HEIGHT + OVERLAY_EXPORT_TILE_SIZE - 1) / OVERLAY_EXPORT_TILE_SIZE))
+
+// shared frame
+struct OverlayExportSlot {
+	volatile int32_t sequence;									// odd while the frame is written, incremented before and after
+	int32_t tileCount;											// number of stored tiles
+	volatile int64_t frame;										// frame counter of the frame
+	int32_t width;												// frame width in pixels
+	int32_t height;												// frame height in pixels
+	int32_t dirtyLeft;											// area changed compared to the previous frame,
+	int32_t dirtyTop;											// empty if the frame is unchanged
+	int32_t dirtyRight;
+	int32_t dirtyBottom;
+	uint64_t offset;											// offset of the tile pixels from the start of the shared memory
+	uint16_t tiles[OVERLAY_EXPORT_MAX_TILES];					// screen tile of each stored tile
+};
+
+// header of the shared memory
+struct OverlayExportHeader {
+	volatile uint32_t magic;									// OVERLAY_EXPORT_MAGIC
+	uint32_t version;											// OVERLAY_EXPORT_VERSION
+	uint32_t slotCount;											// OVERLAY_EXPORT_SLOTS
+	int32_t tileSize;											// OVERLAY_EXPORT_TILE_SIZE
+	volatile int64_t frame;										// frame counter of the latest published frame
+	volatile int32_t latestSlot;								// slot of the latest published frame
+	int32_t reserved;
+	struct OverlayExportSlot slots[OVERLAY_EXPORT_SLOTS];			// shared frames
+};
+
+#if defined(__GNUC__)
+
+/*
+ * Mark frame as being written (producer), sequence is the producer's private copy of the slot sequence
+ */
+static inline void OverlayBeginWrite(struct OverlayExportSlot *slot, int32_t *sequence) {
+	*sequence += 1;
+	__atomic_store_n(&slot->sequence, *sequence, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*
+ * Mark frame as complete (producer), sequence is the producer's private copy of the slot sequence
+ */
+static inline void OverlayEndWrite(struct OverlayExportSlot *slot, int32_t *sequence) {
+	*sequence += 1;
+	__atomic_store_n(&slot->sequence, *sequence, __ATOMIC_RELEASE);
+}
+
+/*
+ * Make a complete frame the latest frame (producer)
+ */
+static inline void OverlayPublish(struct OverlayExportHeader *header, int32_t slot, int64_t frame) {
+	__atomic_store_n(&header->latestSlot, slot, __ATOMIC_RELEASE);
+	__atomic_store_n(&header->frame, frame, __ATOMIC_RELEASE);
+}
+
+/*
+ * Get the slot of the latest frame (consumer)
+ */
+static inline int32_t OverlayLatestSlot(const struct OverlayExportHeader *header) {
+	return __atomic_load_n(&header->latestSlot, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Get the sequence of a frame before reading it (consumer), the frame is being written if it is odd
+ */
+static inline int32_t OverlayBeginRead(const struct OverlayExportSlot *slot) {
+	return __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Check that a frame has not been written while reading it (consumer)
+ */
+static inline int OverlayEndRead(const struct OverlayExportSlot *slot, int32_t sequence) {
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Crosshairs shapes
+ *
+ * Geometry of the supported crosshairs shapes as drawing primitives. The
+ * dynamic spread moves the arms of the cross shapes outwards. Free of
+ * Windows dependencies.
+ */
+
+#ifndef RETICLE_H
+#define RETICLE_H
+
+#include <stdint.h>
+
+#include "tiles.h"
+
+#define NUM_SHAPES				16								// number of crosshairs shapes
+#define TICK_COUNT				10								// number of tick marks per crosshairs arm
+#define MIN_TICK_SPACING		4								// min. distance between tick marks in pixels
+#define TICK_LENGTH				3								// length of tick marks on each side of the line in pixels
+
+/*
+ * Collect the drawing primitives of a crosshairs shape with the given size, pen width and additional gap
+ * caused by the dynamic spread (only used by the cross shapes with a gap in the center)
+ */
+inline void BuildReticle(Reticle &reticle, int32_t shape, int32_t centerX, int32_t centerY, int32_t size, int32_t penWidth, int32_t spread) {
+	int sideLength = size / 2;
+	int32_t tickSpacing = (size / TICK_COUNT > MIN_TICK_SPACING) ? size / TICK_COUNT : MIN_TICK_SPACING;
+
+	// collect the selected crosshairs shape
+	switch (shape) {
+		case 0:
+			// cross
+			AddLine(reticle, centerX - size, centerY, centerX + size, centerY);
+			AddLine(reticle, centerX, centerY - size, centerX, centerY + size);
+			break;
+
+		case 1:
+			// cross with small gap in the center
+			AddLine(reticle, centerX - size - spread, centerY, centerX - penWidth - spread, centerY);
+			AddLine(reticle, centerX + penWidth + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - penWidth - spread);
+			AddLine(reticle, centerX, centerY + penWidth + spread, centerX, centerY + size + spread);
+			break;
+
+		case 2:
+			// cross with a large gap in the center
+			AddLine(reticle, centerX - size - spread, centerY, centerX - sideLength - spread, centerY);
+			AddLine(reticle, centerX + sideLength + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - sideLength - spread);
+			AddLine(reticle, centerX, centerY + sideLength + spread, centerX, centerY + size + spread);
+			break;
+
+		case 3:
+			// cross with a small gap in the center
+			AddLine(reticle, centerX - size - spread, centerY, centerX - sideLength * (0.75) - spread, centerY);
+			AddLine(reticle, centerX + sideLength * (0.75) + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - sideLength * (0.75) - spread);
+			AddLine(reticle, centerX, centerY + sideLength * (0.75) + spread, centerX, centerY + size + spread);
+			break;
+
+		case 4:
+			// cross with a small gap in the center
+			AddLine(reticle, centerX - size - spread, centerY, centerX - sideLength / 2 - spread, centerY);
+			AddLine(reticle, centerX + sideLength / 2 + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - sideLength / 2 - spread);
+			AddLine(reticle, centerX, centerY + sideLength / 2 + spread, centerX, centerY + size + spread);
+			break;
+
+		case 5:
+			// cross with a large gap in the center and a center dot
+			AddLine(reticle, centerX - size - spread, centerY, centerX - sideLength - spread, centerY);
+			AddLine(reticle, centerX + sideLength + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - sideLength - spread);
+			AddLine(reticle, centerX, centerY + sideLength + spread, centerX, centerY + size + spread);
+			AddFilledRectangle(reticle, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			break;
+
+		case 6:
+			// cross with a medium gap in the center and center dot
+			AddLine(reticle, centerX - size - spread, centerY, centerX - sideLength * 0.75 - spread, centerY);
+			AddLine(reticle, centerX + sideLength * 0.75 + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - sideLength * 0.75 - spread);
+			AddLine(reticle, centerX, centerY + sideLength * 0.75 + spread, centerX, centerY + size + spread);
+			AddFilledRectangle(reticle, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			break;
+
+		case 7:
+			// cross with a small gap in the center and center dot
+			AddLine(reticle, centerX - size - spread, centerY, centerX - sideLength / 2 - spread, centerY);
+			AddLine(reticle, centerX + sideLength / 2 + spread, centerY, centerX + size + spread, centerY);
+			AddLine(reticle, centerX, centerY - size - spread, centerX, centerY - sideLength / 2 - spread);
+			AddLine(reticle, centerX, centerY + sideLength / 2 + spread, centerX, centerY + size + spread);
+			AddFilledRectangle(reticle, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			break;
+
+		case 8:
+			// circle with a center dot
+			reticle.antiAlias = true;
+			AddEllipse(reticle, centerX - size, centerY - size, 2 * size, 2 * size);
+			AddFilledRectangle(reticle, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			break;
+
+		case 9:
+			// circle with a small center cross
+			AddLine(reticle, centerX - size / 4, centerY, centerX + size / 4, centerY);
+			AddLine(reticle, centerX, centerY - size / 4, centerX, centerY + size / 4);
+			reticle.antiAlias = true;
+			AddEllipse(reticle, centerX - size, centerY - size, 2 * size, 2 * size);
+			break;
+
+		case 10:
+			// center dot
+			reticle.antiAlias = true;
+			AddFilledRectangle(reticle, centerX - penWidth / 2, centerY - penWidth / 2, penWidth, penWidth);
+			break;
+
+		case 11:
+			// cross with large circle
+			AddLine(reticle, centerX - size, centerY, centerX + size, centerY);
+			AddLine(reticle, centerX, centerY - size, centerX, centerY + size);
+			reticle.antiAlias = true;
+			AddEllipse(reticle, centerX - size, centerY - size,  2 * size, 2 * size);
+			break;
+
+		case 12:
+			// cross with medium circle
+			AddLine(reticle, centerX - size, centerY, centerX + size, centerY);
+			AddLine(reticle, centerX, centerY - size, centerX, centerY + size);
+			reticle.antiAlias = true;
+			AddEllipse(reticle, centerX - size / 2, centerY - size / 2, size, size);
+			break;
+
+		case 13:
+			// cross with medium rectangle
+			AddLine(reticle, centerX - size, centerY, centerX + size, centerY);
+			AddLine(reticle, centerX, centerY - size, centerX, centerY + size);
+			AddRectangle(reticle, centerX - size / 2, centerY - size / 2, size, size);
+			break;
+
+		case 14:
+			// circle with one lower vertical line
+			AddLine(reticle, centerX, centerY, centerX, centerY + size);
+			reticle.antiAlias = true;
+			AddEllipse(reticle, centerX - size, centerY - size, 2 * size, 2 * size);
+			break;
+
+		case 15:
+			// cross with tick marks (rangefinder)
+			AddLine(reticle, centerX - size, centerY, centerX + size, centerY);
+			AddLine(reticle, centerX, centerY - size, centerX, centerY + size);
+			for (int32_t tick = tickSpacing; tick <= size; tick += tickSpacing) {
+				AddLine(reticle, centerX - tick, centerY - TICK_LENGTH, centerX - tick, centerY + TICK_LENGTH);
+				AddLine(reticle, centerX + tick, centerY - TICK_LENGTH, centerX + tick, centerY + TICK_LENGTH);
+				AddLine(reticle, centerX - TICK_LENGTH, centerY - tick, centerX + TICK_LENGTH, centerY - tick);
+				AddLine(reticle, centerX - TICK_LENGTH, centerY + tick, centerX + TICK_LENGTH, centerY + tick);
+			}
+			break;
+	}
+}
+
+#endif
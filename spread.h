@@ -0,0 +1,131 @@
+/*
+ * Dynamic crosshairs spread
+ *
+ * Queue for raw mouse movements passed from the input thread to the user
+ * interface thread, and filter mapping the mouse velocity to an additional
+ * crosshairs gap. Both are free of Windows dependencies.
+ */
+
+#ifndef SPREAD_H
+#define SPREAD_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#define MAX_SPREAD				32								// max. additional crosshairs gap in pixels caused by mouse movement
+#define SPREAD_MIN_VELOCITY		1000.0							// mouse velocity in counts per second below which there is no spread (sensor jitter)
+#define SPREAD_FULL_VELOCITY	10000.0							// mouse velocity in counts per second causing the max. spread
+#define SPREAD_RECOVERY_TIME	150.0							// time constant in milliseconds for recovering from spread
+#define INPUT_QUEUE_SIZE		1024							// number of buffered raw mouse movements (power of two)
+
+// raw mouse movement
+struct MouseMove {
+	int32_t dx;													// relative X movement in mouse counts
+	int32_t dy;													// relative Y movement in mouse counts
+};
+
+// lock-free single-producer single-consumer queue for raw mouse movements
+struct InputQueue {
+	MouseMove moves[INPUT_QUEUE_SIZE];							// ring buffer
+	alignas(64) std::atomic<uint32_t> head;						// next write position (only written by the producer)
+	alignas(64) std::atomic<uint32_t> tail;						// next read position (only written by the consumer)
+};
+
+// filtered crosshairs spread
+struct SpreadFilter {
+	double spread;												// filtered spread in pixels
+	int32_t gap;												// quantized additional crosshairs gap in pixels
+};
+
+/*
+ * Add mouse movement to the queue (producer only), fails if the queue is full
+ */
+inline bool PushMouseMove(InputQueue &queue, const MouseMove &move) {
+	uint32_t head = queue.head.load(std::memory_order_relaxed);
+	uint32_t tail = queue.tail.load(std::memory_order_acquire);
+
+	if (head - tail == INPUT_QUEUE_SIZE) {
+		// queue is full
+		return false;
+	}
+
+	queue.moves[head & (INPUT_QUEUE_SIZE - 1)] = move;
+	queue.head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+/*
+ * Remove mouse movement from the queue (consumer only), fails if the queue is empty
+ */
+inline bool PopMouseMove(InputQueue &queue, MouseMove &move) {
+	uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+	uint32_t head = queue.head.load(std::memory_order_acquire);
+
+	if (head == tail) {
+		// queue is empty
+		return false;
+	}
+
+	move = queue.moves[tail & (INPUT_QUEUE_SIZE - 1)];
+	queue.tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+/*
+ * Remove all mouse movements from the queue (consumer only) and return the distance moved
+ */
+inline double DrainMouseMoves(InputQueue &queue) {
+	MouseMove move;
+	double distance = 0.0;
+
+	while (PopMouseMove(queue, move)) {
+		distance += sqrt((double)move.dx * move.dx + (double)move.dy * move.dy);
+	}
+	return distance;
+}
+
+/*
+ * Reset spread filter to no spread
+ */
+inline void ResetSpread(SpreadFilter &filter) {
+	filter.spread = 0.0;
+	filter.gap = 0;
+}
+
+/*
+ * Update spread filter with the distance in mouse counts moved within the elapsed time in milliseconds,
+ * returns true if the quantized gap has changed
+ */
+inline bool StepSpread(SpreadFilter &filter, double distance, double elapsed) {
+	if (elapsed <= 0.0) {
+		return false;
+	}
+
+	// map mouse velocity to the target spread
+	double velocity = distance * 1000.0 / elapsed;
+	double target = MAX_SPREAD * (velocity - SPREAD_MIN_VELOCITY) / (SPREAD_FULL_VELOCITY - SPREAD_MIN_VELOCITY);
+	if (target < 0.0) {
+		target = 0.0;
+	} else if (target > MAX_SPREAD) {
+		target = MAX_SPREAD;
+	}
+
+	// widen immediately, recover exponentially
+	if (target >= filter.spread) {
+		filter.spread = target;
+	} else {
+		filter.spread = target + (filter.spread - target) * exp(-elapsed / SPREAD_RECOVERY_TIME);
+	}
+
+	// only report a change if the quantized gap has changed
+	int32_t gap = (int32_t)(filter.spread + 0.5);
+	if (gap == filter.gap) {
+		return false;
+	}
+	filter.gap = gap;
+	return true;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Benchmark of raw mouse movements handled per second by the input queue and the spread filter
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "spread.h"
+
+#define EVENT_COUNT		20000000								// number of mouse movements per run
+
+InputQueue queue = {};
+
+/*
+ * Input thread pushing movements, UI thread draining the queue and stepping the filter as fast as possible
+ */
+void BenchThreads() {
+	std::atomic<bool> done(false);
+	uint64_t retries = 0;
+	uint64_t steps = 0;
+	uint64_t redraws = 0;
+	SpreadFilter filter = {};
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::thread producer([&]() {
+		for (int32_t i = 0; i < EVENT_COUNT; i++) {
+			MouseMove move = {(i & 15) - 7, (i & 7) - 3};
+			while (!PushMouseMove(queue, move)) {
+				retries++;
+				std::this_thread::yield();
+			}
+		}
+		done.store(true);
+	});
+
+	while (!done.load() || (queue.head.load() != queue.tail.load())) {
+		double distance = DrainMouseMoves(queue);
+		if (StepSpread(filter, distance, 1.0)) {
+			redraws++;
+		}
+		steps++;
+		std::this_thread::yield();
+	}
+	producer.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("queue + filter, 2 threads: %.1f M events/s (%llu filter steps, %llu redraws, %llu retries on full queue)\n",
+		EVENT_COUNT / seconds / 1e6, (unsigned long long)steps, (unsigned long long)redraws, (unsigned long long)retries);
+}
+
+/*
+ * Single thread pushing a batch and stepping the filter once per batch, as the UI thread does per timer tick
+ */
+void BenchBatches() {
+	SpreadFilter filter = {};
+	double checksum = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int32_t i = 0; i < EVENT_COUNT; i += 80) {
+		// 80 events per 10 ms tick correspond to a mouse with 8000 Hz polling rate
+		for (int32_t j = 0; j < 80; j++) {
+			MouseMove move = {(j & 15) - 7, (j & 7) - 3};
+			PushMouseMove(queue, move);
+		}
+		StepSpread(filter, DrainMouseMoves(queue), 10.0);
+		checksum += filter.spread;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("queue + filter, 1 thread, 80 events per tick: %.1f M events/s (checksum %.1f)\n", EVENT_COUNT / seconds / 1e6, checksum);
+}
+
+int main() {
+	BenchThreads();
+	BenchBatches();
+	return 0;
+}
@@ -0,0 +1,265 @@
+/*
+ * Benchmark of memory and time per frame of the sparse tile store compared to a dense full-screen buffer
+ *
+ * Frames alternate between two spread gaps, as while moving the mouse. Primitives are rasterized with a
+ * simple hairline stand-in for GDI+, the same for both variants. The upload is reported as the number of bytes
+ * per frame the layered window update copies from the staging buffer (the whole buffer for the dense variant,
+ * the dirty rectangle for the sparse one), the time the system takes for it is not measured.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "tiles.h"
+
+#define SCREEN_WIDTH	3840										// 4K screen
+#define SCREEN_HEIGHT	2160
+#define FRAME_COUNT		200											// frames per run
+#define PEN_PAD			2.5f										// half pen width plus antialiasing, as used by the app
+#define COLOR			0xffff0000									// opaque red (premultiplied ARGB)
+
+// crosshairs geometry with the given spread gap
+typedef void (*BuildFunction)(Reticle &reticle, int32_t gap);
+
+/*
+ * Full-screen cross
+ */
+void BuildCross(Reticle &reticle, int32_t gap) {
+	float cx = SCREEN_WIDTH / 2;
+	float cy = SCREEN_HEIGHT / 2;
+	AddLine(reticle, 0, cy, cx - gap, cy);
+	AddLine(reticle, cx + gap, cy, SCREEN_WIDTH - 1, cy);
+	AddLine(reticle, cx, 0, cx, cy - gap);
+	AddLine(reticle, cx, cy + gap, cx, SCREEN_HEIGHT - 1);
+}
+
+/*
+ * Small circle with center dot
+ */
+void BuildSmallCircle(Reticle &reticle, int32_t gap) {
+	float cx = SCREEN_WIDTH / 2;
+	float cy = SCREEN_HEIGHT / 2;
+	float radius = 20 + gap;
+	AddEllipse(reticle, cx - radius, cy - radius, 2 * radius, 2 * radius);
+	AddFilledRectangle(reticle, cx - 1, cy - 1, 2, 2);
+}
+
+/*
+ * Circle as large as the screen
+ */
+void BuildLargeCircle(Reticle &reticle, int32_t gap) {
+	float cx = SCREEN_WIDTH / 2;
+	float cy = SCREEN_HEIGHT / 2;
+	float radius = 1000 + gap;
+	AddEllipse(reticle, cx - radius, cy - radius, 2 * radius, 2 * radius);
+}
+
+/*
+ * Full-screen rangefinder, cross with tick marks every 4 pixels
+ */
+void BuildRangefinder(Reticle &reticle, int32_t gap) {
+	BuildCross(reticle, gap);
+
+	float cx = SCREEN_WIDTH / 2;
+	float cy = SCREEN_HEIGHT / 2;
+	for (int32_t d = gap + 4; d < SCREEN_WIDTH / 2; d += 4) {
+		AddLine(reticle, cx - d, cy - 3, cx - d, cy + 3);
+		AddLine(reticle, cx + d, cy - 3, cx + d, cy + 3);
+		if (d < SCREEN_HEIGHT / 2) {
+			AddLine(reticle, cx - 3, cy - d, cx + 3, cy - d);
+			AddLine(reticle, cx - 3, cy + d, cx + 3, cy + d);
+		}
+	}
+}
+
+/*
+ * Plot pixel if it is within the target rectangle
+ */
+inline void Plot(uint32_t *pixels, int32_t stride, const TileRect &rect, int32_t x, int32_t y) {
+	if ((x >= rect.left) && (x < rect.right) && (y >= rect.top) && (y < rect.bottom)) {
+		pixels[(size_t)(y - rect.top) * stride + (x - rect.left)] = COLOR;
+	}
+}
+
+/*
+ * Hairline stand-in rasterizer, drawing the primitive clipped to the target rectangle
+ */
+void RasterPrimitive(const Primitive &p, uint32_t *pixels, int32_t stride, const TileRect &rect) {
+	switch (p.type) {
+		case PRIMITIVE_LINE: {
+			// only step along the part of the line within the target rectangle
+			float dx = p.x2 - p.x1;
+			float dy = p.y2 - p.y1;
+			int32_t steps = (int32_t)((fabsf(dx) > fabsf(dy)) ? fabsf(dx) : fabsf(dy));
+			float t1 = 0;
+			float t2 = 1;
+			if (dx != 0) {
+				float ta = (rect.left - 1 - p.x1) / dx;
+				float tb = (rect.right - p.x1) / dx;
+				t1 = fmaxf(t1, fminf(ta, tb));
+				t2 = fminf(t2, fmaxf(ta, tb));
+			}
+			if (dy != 0) {
+				float ta = (rect.top - 1 - p.y1) / dy;
+				float tb = (rect.bottom - p.y1) / dy;
+				t1 = fmaxf(t1, fminf(ta, tb));
+				t2 = fminf(t2, fmaxf(ta, tb));
+			}
+			for (int32_t i = (int32_t)(t1 * steps); i <= (int32_t)ceilf(t2 * steps) && (i <= steps); i++) {
+				float t = steps ? (float)i / steps : 0;
+				Plot(pixels, stride, rect, (int32_t)(p.x1 + t * dx), (int32_t)(p.y1 + t * dy));
+			}
+			break;
+		}
+
+		case PRIMITIVE_ELLIPSE: {
+			// outline points per row and per column within the target rectangle
+			float rx = p.x2 / 2;
+			float ry = p.y2 / 2;
+			float cx = p.x1 + rx;
+			float cy = p.y1 + ry;
+			for (int32_t y = rect.top; y < rect.bottom; y++) {
+				float v = (y - cy) / ry;
+				if (v * v <= 1) {
+					float u = rx * sqrtf(1 - v * v);
+					Plot(pixels, stride, rect, (int32_t)(cx - u), y);
+					Plot(pixels, stride, rect, (int32_t)(cx + u), y);
+				}
+			}
+			for (int32_t x = rect.left; x < rect.right; x++) {
+				float u = (x - cx) / rx;
+				if (u * u <= 1) {
+					float v = ry * sqrtf(1 - u * u);
+					Plot(pixels, stride, rect, x, (int32_t)(cy - v));
+					Plot(pixels, stride, rect, x, (int32_t)(cy + v));
+				}
+			}
+			break;
+		}
+
+		case PRIMITIVE_RECTANGLE:
+		case PRIMITIVE_FILLED_RECTANGLE:
+			for (int32_t y = (int32_t)p.y1; y <= (int32_t)(p.y1 + p.y2); y++) {
+				for (int32_t x = (int32_t)p.x1; x <= (int32_t)(p.x1 + p.x2); x++) {
+					Plot(pixels, stride, rect, x, y);
+				}
+			}
+			break;
+	}
+}
+
+/*
+ * Rasterize the primitives touching a tile (UpdateTiles callback)
+ */
+void RasterTile(void *, uint32_t *pixels, const TileRect &rect, const Reticle &reticle, const std::vector<uint32_t> &primitives) {
+	for (uint32_t i : primitives) {
+		RasterPrimitive(reticle.primitives[i], pixels, TILE_SIZE, rect);
+	}
+}
+
+/*
+ * Dense buffer: clear and redraw the whole screen per frame, and upload all of it
+ */
+void BenchDense(const Reticle reticles[2], double &milliseconds, double &megabytes, double &uploadMegabytes) {
+	std::vector<uint32_t> pixels((size_t)SCREEN_WIDTH * SCREEN_HEIGHT);
+	TileRect screen = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t frame = 0; frame < FRAME_COUNT; frame++) {
+		const Reticle &reticle = reticles[frame & 1];
+		memset(pixels.data(), 0, pixels.size() * sizeof(uint32_t));
+		for (const Primitive &p : reticle.primitives) {
+			RasterPrimitive(p, pixels.data(), SCREEN_WIDTH, screen);
+		}
+	}
+	milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / FRAME_COUNT;
+	megabytes = pixels.size() * sizeof(uint32_t) / 1e6;
+	uploadMegabytes = megabytes;
+}
+
+/*
+ * Sparse tiles: bin, rasterize only the changed tiles containing geometry, compose the changed tiles into a staging
+ * buffer covering the tiles containing geometry and upload their bounds, as done by the app
+ */
+void BenchSparse(const Reticle reticles[2], double &milliseconds, double &tileMegabytes, double &stagingMegabytes,
+		double &uploadMegabytes, size_t &tileCount) {
+	TileStore store = {};
+	TileBins bins;
+	TileMask shown;
+	TileMask dirty;
+	InitTileStore(store, SCREEN_WIDTH, SCREEN_HEIGHT);
+	InitTileBins(bins, store.grid);
+	InitTileMask(shown, store.grid);
+	InitTileMask(dirty, store.grid);
+
+	std::vector<uint32_t> staging;
+	TileRect stagingBounds = {};
+	double uploadBytes = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t frame = 0; frame < FRAME_COUNT; frame++) {
+		const Reticle &reticle = reticles[frame & 1];
+		BinPrimitives(store.grid, reticle, PEN_PAD, bins);
+		UpdateTiles(store, bins, reticle, false, RasterTile, NULL, shown, dirty);
+
+		TileRect bounds = GetTileBounds(store.grid, shown);
+		int32_t width = bounds.right - bounds.left;
+		if (memcmp(&bounds, &stagingBounds, sizeof(TileRect)) != 0) {
+			staging.assign((size_t)width * (bounds.bottom - bounds.top), 0);
+			ComposeTiles(store, bounds, staging.data(), width, bounds.left, bounds.top);
+			stagingBounds = bounds;
+			uploadBytes += staging.size() * sizeof(uint32_t);
+		} else if (!dirty.marked.empty()) {
+			for (int32_t index : dirty.marked) {
+				ComposeTiles(store, GetTileRect(store.grid, index), staging.data(), width, bounds.left, bounds.top);
+			}
+			TileRect area = GetTileBounds(store.grid, dirty);
+			uploadBytes += (double)(area.right - area.left) * (area.bottom - area.top) * sizeof(uint32_t);
+		}
+	}
+	milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / FRAME_COUNT;
+	uploadMegabytes = uploadBytes / FRAME_COUNT / 1e6;
+	tileCount = store.allocatedTiles;
+	tileMegabytes = store.allocatedTiles * TILE_PIXELS * sizeof(uint32_t) / 1e6;
+	stagingMegabytes = staging.size() * sizeof(uint32_t) / 1e6;
+	FreeTileStore(store);
+}
+
+/*
+ * Compare both variants for a crosshairs shape
+ */
+void Bench(const char *name, BuildFunction build) {
+	Reticle reticles[2] = {};
+	build(reticles[0], 0);
+	build(reticles[1], 1);
+
+	double denseTime;
+	double denseMemory;
+	double denseUpload;
+	BenchDense(reticles, denseTime, denseMemory, denseUpload);
+
+	double sparseTime;
+	double tileMemory;
+	double stagingMemory;
+	double sparseUpload;
+	size_t tileCount;
+	BenchSparse(reticles, sparseTime, tileMemory, stagingMemory, sparseUpload, tileCount);
+
+	printf("%-12s dense: %6.2f ms/frame, %5.1f MB, upload %5.1f MB/frame | "
+		"sparse: %6.2f ms/frame, %4zu tiles %5.2f MB + staging %5.1f MB, upload %6.3f MB/frame\n",
+		name, denseTime, denseMemory, denseUpload, sparseTime, tileCount, tileMemory, stagingMemory, sparseUpload);
+}
+
+int main() {
+	printf("%d x %d screen, %d frames per run, upload time not measured\n", SCREEN_WIDTH, SCREEN_HEIGHT, FRAME_COUNT);
+	Bench("cross", BuildCross);
+	Bench("circle", BuildSmallCircle);
+	Bench("large circle", BuildLargeCircle);
+	Bench("rangefinder", BuildRangefinder);
+	return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * Minimal test helpers
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int testFailures = 0;									// number of failed checks
+
+// check condition, report and count failures
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			testFailures++; \
+		} \
+	} while (0)
+
+// print test summary and return exit code
+static inline int TestResult(const char *name) {
+	if (testFailures) {
+		printf("%s: %d check(s) failed\n", name, testFailures);
+		return 1;
+	}
+	printf("%s: all checks passed\n", name);
+	return 0;
+}
+
+#endif
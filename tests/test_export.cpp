@@ -0,0 +1,359 @@
+/*
+ * Tests of the shared frame export protocol with a producer thread and a consumer in separate mappings of a
+ * memfd, checking the integrity of every consumed frame and reporting the latency from publishing to consuming.
+ * A stalled consumer makes the producer overwrite the frame being read.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "overlayexport.h"
+#include "test.h"
+
+#define FRAME_COUNT		3000										// frames per run
+#define RESIZE_FRAMES	500											// frames between resolution changes
+#define MAX_TEST_TILES	64											// max. tiles per test frame
+#define STALL_READS		4											// a stalled consumer stalls every STALL_READS reads
+#define STALL_TIME		5000										// stall time in microseconds, longer than three produced frames
+
+// shared memory
+struct Mapping {
+	int fd;														// memfd
+	size_t size;												// size in bytes
+	uint64_t headerSize;										// size of the header, page aligned
+	uint64_t frameSize;											// size of the tile pixels per slot
+};
+
+// private state of the producer, it never reads from the shared memory
+struct Producer {
+	OverlayExportHeader *header;								// header of the shared memory
+	uint32_t *tiles[OVERLAY_EXPORT_SLOTS];						// tile pixels of each slot
+	int32_t sequences[OVERLAY_EXPORT_SLOTS];					// sequence of each slot
+	int32_t latestSlot;											// slot published last
+};
+
+// consumer statistics
+struct Consumed {
+	int32_t frames;												// number of consumed frames
+	int32_t discarded;											// number of copies discarded because of concurrent writes
+	int32_t resizes;											// number of observed resolution changes
+	std::vector<double> latencies;								// publish to consume latency in microseconds
+};
+
+std::atomic<int64_t> publishTimes[FRAME_COUNT + 1];				// publish time of each frame in nanoseconds
+
+/*
+ * Current time in nanoseconds
+ */
+int64_t Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Frame size of a test frame, changing every RESIZE_FRAMES frames
+ */
+void FrameSize(int64_t frame, int32_t &width, int32_t &height) {
+	bool large = ((frame / RESIZE_FRAMES) & 1) != 0;
+	width = large ? 3840 : 1920;
+	height = large ? 2160 : 1080;
+}
+
+/*
+ * Number of tiles of a test frame
+ */
+int32_t FrameTileCount(int64_t frame) {
+	return 1 + (int32_t)((frame * 7) % MAX_TEST_TILES);
+}
+
+/*
+ * Screen tile of the i-th stored tile of a test frame (distinct, as 37 is coprime to the tile counts used)
+ */
+int32_t FrameTile(int64_t frame, int32_t i) {
+	int32_t width;
+	int32_t height;
+	FrameSize(frame, width, height);
+	int32_t tiles = ((width + OVERLAY_EXPORT_TILE_SIZE - 1) / OVERLAY_EXPORT_TILE_SIZE) * ((height + OVERLAY_EXPORT_TILE_SIZE - 1) / OVERLAY_EXPORT_TILE_SIZE);
+	return (int32_t)((frame * 13 + (int64_t)i * 37) % tiles);
+}
+
+/*
+ * Pixel of a test frame
+ */
+uint32_t Pattern(int64_t frame, int32_t tile, int32_t pixel) {
+	return ((uint32_t)frame * 0x9E3779B1u) ^ ((uint32_t)tile << 12) ^ (uint32_t)pixel;
+}
+
+/*
+ * Create shared memory with the layout used by Fadenkreuz, only touched pages are allocated
+ */
+bool CreateMapping(Mapping &mapping) {
+	mapping.headerSize = (sizeof(OverlayExportHeader) + 4095) & ~(uint64_t)4095;
+	mapping.frameSize = (uint64_t)OVERLAY_EXPORT_MAX_TILES * OVERLAY_EXPORT_TILE_BYTES;
+	mapping.size = mapping.headerSize + OVERLAY_EXPORT_SLOTS * mapping.frameSize;
+
+	mapping.fd = memfd_create("FadenkreuzOverlay", 0);
+	if ((mapping.fd < 0) || (ftruncate(mapping.fd, (off_t)mapping.size) != 0)) {
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Map shared memory, as done by the producer and each consumer
+ */
+uint8_t *MapShared(const Mapping &mapping, bool writable) {
+	void *view = mmap(NULL, mapping.size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, mapping.fd, 0);
+	return (view == MAP_FAILED) ? NULL : (uint8_t*)view;
+}
+
+/*
+ * Initialize header and the private state of the producer, as done by CreateFrameExport
+ */
+void InitHeader(const Mapping &mapping, OverlayExportHeader *header, Producer &producer) {
+	header->magic = 0;
+	header->version = OVERLAY_EXPORT_VERSION;
+	header->slotCount = OVERLAY_EXPORT_SLOTS;
+	header->tileSize = OVERLAY_EXPORT_TILE_SIZE;
+	header->frame = 0;
+	header->latestSlot = 0;
+
+	for (uint32_t slot = 0; slot < OVERLAY_EXPORT_SLOTS; slot++) {
+		OverlayExportSlot &exportSlot = header->slots[slot];
+		memset(&exportSlot, 0, sizeof(OverlayExportSlot));
+		exportSlot.offset = mapping.headerSize + slot * mapping.frameSize;
+
+		producer.tiles[slot] = (uint32_t*)((uint8_t*)header + mapping.headerSize + slot * mapping.frameSize);
+		producer.sequences[slot] = 0;
+	}
+	producer.header = header;
+	producer.latestSlot = 0;
+	__atomic_store_n(&header->magic, OVERLAY_EXPORT_MAGIC, __ATOMIC_RELEASE);
+}
+
+/*
+ * Write and publish a test frame, as done by BeginExportFrame, the tile rendering and PublishFrame
+ */
+void ProduceFrame(Producer &producer, int64_t frame) {
+	int32_t slot = (producer.latestSlot + 1) % OVERLAY_EXPORT_SLOTS;
+	OverlayExportSlot &exportSlot = producer.header->slots[slot];
+	uint32_t *tilePixels = producer.tiles[slot];
+	int32_t tileCount = FrameTileCount(frame);
+
+	OverlayBeginWrite(&exportSlot, &producer.sequences[slot]);
+	for (int32_t i = 0; i < tileCount; i++) {
+		int32_t tile = FrameTile(frame, i);
+		uint32_t *pixels = tilePixels + (size_t)i * OVERLAY_EXPORT_TILE_BYTES / 4;
+		for (int32_t p = 0; p < OVERLAY_EXPORT_TILE_BYTES / 4; p++) {
+			pixels[p] = Pattern(frame, tile, p);
+		}
+		exportSlot.tiles[i] = (uint16_t)tile;
+	}
+	exportSlot.tileCount = tileCount;
+	exportSlot.frame = frame;
+	FrameSize(frame, exportSlot.width, exportSlot.height);
+	exportSlot.dirtyLeft = 0;
+	exportSlot.dirtyTop = 0;
+	exportSlot.dirtyRight = exportSlot.width;
+	exportSlot.dirtyBottom = exportSlot.height;
+	OverlayEndWrite(&exportSlot, &producer.sequences[slot]);
+
+	publishTimes[frame].store(Now(), std::memory_order_relaxed);
+	OverlayPublish(producer.header, slot, frame);
+	producer.latestSlot = slot;
+}
+
+/*
+ * Read the latest frame following the documented steps and check it, returns false if there is no new frame,
+ * stall is the time in microseconds to wait between copying the frame and checking its sequence
+ */
+bool ConsumeFrame(const OverlayExportHeader *header, int64_t &lastFrame, int32_t stall, Consumed &consumed) {
+	static std::vector<uint16_t> tiles(OVERLAY_EXPORT_MAX_TILES);
+	static std::vector<uint32_t> pixels((size_t)MAX_TEST_TILES * OVERLAY_EXPORT_TILE_BYTES / 4);
+
+	// 1. check magic and version
+	if ((__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != OVERLAY_EXPORT_MAGIC) || (header->version != OVERLAY_EXPORT_VERSION)) {
+		return false;
+	}
+
+	// 2. read latestSlot, and the sequence of this slot
+	const OverlayExportSlot &exportSlot = header->slots[OverlayLatestSlot(header)];
+	int32_t sequence = OverlayBeginRead(&exportSlot);
+	if ((sequence & 1) || (exportSlot.frame == lastFrame)) {
+		return false;
+	}
+
+	// 3. copy the tiles
+	int64_t frame = exportSlot.frame;
+	int32_t width = exportSlot.width;
+	int32_t height = exportSlot.height;
+	int32_t tileCount = exportSlot.tileCount;
+	if ((tileCount < 0) || (tileCount > MAX_TEST_TILES)) {
+		tileCount = 0;
+	}
+	const uint8_t *tilePixels = (const uint8_t*)header + exportSlot.offset;
+	memcpy(tiles.data(), (const void*)exportSlot.tiles, tileCount * sizeof(uint16_t));
+	memcpy(pixels.data(), tilePixels, (size_t)tileCount * OVERLAY_EXPORT_TILE_BYTES);
+	if (stall > 0) {
+		std::this_thread::sleep_for(std::chrono::microseconds(stall));
+	}
+
+	// 4. discard the copy if the slot has been written meanwhile
+	if (!OverlayEndRead(&exportSlot, sequence)) {
+		consumed.discarded++;
+		return false;
+	}
+	int64_t published = publishTimes[frame].load(std::memory_order_relaxed);
+	consumed.latencies.push_back((Now() - published) / 1000.0);
+
+	// check integrity of the frame
+	CHECK((frame > lastFrame) && (frame <= FRAME_COUNT));
+	int32_t expectedWidth;
+	int32_t expectedHeight;
+	FrameSize(frame, expectedWidth, expectedHeight);
+	CHECK((width == expectedWidth) && (height == expectedHeight));
+	CHECK(tileCount == FrameTileCount(frame));
+
+	bool intact = true;
+	for (int32_t i = 0; i < tileCount; i++) {
+		intact = intact && (tiles[i] == FrameTile(frame, i));
+		const uint32_t *tile = pixels.data() + (size_t)i * OVERLAY_EXPORT_TILE_BYTES / 4;
+		for (int32_t p = 0; p < OVERLAY_EXPORT_TILE_BYTES / 4; p++) {
+			intact = intact && (tile[p] == Pattern(frame, tiles[i], p));
+		}
+	}
+	CHECK(intact);
+
+	int32_t lastWidth;
+	int32_t lastHeight;
+	FrameSize(lastFrame, lastWidth, lastHeight);
+	if ((lastFrame > 0) && (lastWidth != width)) {
+		consumed.resizes++;
+	}
+
+	lastFrame = frame;
+	consumed.frames++;
+	return true;
+}
+
+/*
+ * Sequence numbers detect frames written while being read
+ */
+void TestSequence() {
+	OverlayExportSlot slot = {};
+	int32_t written = 0;
+
+	int32_t sequence = OverlayBeginRead(&slot);
+	CHECK(sequence == 0);
+	CHECK(OverlayEndRead(&slot, sequence));
+
+	OverlayBeginWrite(&slot, &written);
+	CHECK(OverlayBeginRead(&slot) & 1);
+	OverlayEndWrite(&slot, &written);
+	CHECK((OverlayBeginRead(&slot) == 2) && (written == 2));
+	CHECK(!OverlayEndRead(&slot, sequence));
+
+	// the producer does not read back sequences changed by other processes
+	slot.sequence = 1000;
+	OverlayBeginWrite(&slot, &written);
+	CHECK(OverlayBeginRead(&slot) == 3);
+	OverlayEndWrite(&slot, &written);
+	CHECK(OverlayBeginRead(&slot) == 4);
+}
+
+/*
+ * Layout fits the max. screen size and keeps tile pixels page aligned
+ */
+void TestLayout() {
+	CHECK(OVERLAY_EXPORT_MAX_TILES == 120 * 68);
+	CHECK(OVERLAY_EXPORT_MAX_TILES <= 65536);
+	CHECK(OVERLAY_EXPORT_TILE_BYTES % 4096 == 0);
+	CHECK(offsetof(OverlayExportHeader, slots) % 8 == 0);
+	CHECK(sizeof(OverlayExportSlot) % 8 == 0);
+}
+
+/*
+ * Producer thread publishing frames, consumer reading them in its own mapping, optionally stalling while reading
+ */
+void TestProducerConsumer(const char *name, bool paced, bool stalled) {
+	Mapping mapping = {};
+	CHECK(CreateMapping(mapping));
+	uint8_t *producerView = MapShared(mapping, true);
+	uint8_t *consumerView = MapShared(mapping, false);
+	CHECK(producerView && consumerView);
+	if (!producerView || !consumerView) {
+		return;
+	}
+
+	OverlayExportHeader *header = (OverlayExportHeader*)producerView;
+	Producer state = {};
+	InitHeader(mapping, header, state);
+	for (std::atomic<int64_t> &time : publishTimes) {
+		time.store(0);
+	}
+
+	std::atomic<bool> done(false);
+	std::thread producer([&]() {
+		for (int64_t frame = 1; frame <= FRAME_COUNT; frame++) {
+			ProduceFrame(state, frame);
+			if (paced) {
+				std::this_thread::sleep_for(std::chrono::microseconds(500));
+			} else {
+				std::this_thread::yield();
+			}
+		}
+		done.store(true);
+	});
+
+	Consumed consumed = {};
+	int64_t lastFrame = 0;
+	int32_t reads = 0;
+	const OverlayExportHeader *consumerHeader = (const OverlayExportHeader*)consumerView;
+	while (!done.load() || (lastFrame != FRAME_COUNT)) {
+		int32_t stall = (stalled && (++reads % STALL_READS == 0)) ? STALL_TIME : 0;
+		if (!ConsumeFrame(consumerHeader, lastFrame, stall, consumed)) {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	// the last frame is always consumed, resolution changes need no re-open
+	CHECK(lastFrame == FRAME_COUNT);
+	CHECK(consumed.frames > 0);
+	if (paced) {
+		CHECK(consumed.resizes > 0);
+	}
+
+	// the producer has wrapped around the slots while the stalled consumer was reading, every accepted frame is intact
+	if (stalled) {
+		CHECK(consumed.discarded > 0);
+	}
+
+	std::vector<double> &latencies = consumed.latencies;
+	std::sort(latencies.begin(), latencies.end());
+	printf("%s: %d of %d frames consumed, %d copies discarded, %d resolution changes, latency median %.1f us, p99 %.1f us, max %.1f us\n",
+		name, consumed.frames, FRAME_COUNT, consumed.discarded, consumed.resizes,
+		latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+
+	munmap(consumerView, mapping.size);
+	munmap(producerView, mapping.size);
+	close(mapping.fd);
+}
+
+int main() {
+	TestSequence();
+	TestLayout();
+	TestProducerConsumer("paced producer", true, false);
+	TestProducerConsumer("flat-out producer", false, false);
+	TestProducerConsumer("stalled consumer", true, true);
+	return TestResult("test_export");
+}
@@ -0,0 +1,103 @@
+/*
+ * Tests of the crosshairs geometry and the dynamic spread gap
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "reticle.h"
+#include "test.h"
+
+#define CENTER_X	960												// center of a full HD screen
+#define CENTER_Y	540
+
+/*
+ * Direction of a crosshairs arm away from the center, 0 for primitives which are not arms
+ */
+void ArmDirection(const Primitive &p, float &dx, float &dy) {
+	dx = 0;
+	dy = 0;
+	if (p.type != PRIMITIVE_LINE) {
+		return;
+	}
+	if ((p.y1 == CENTER_Y) && (p.y2 == CENTER_Y)) {
+		dx = (p.x1 + p.x2 < 2 * CENTER_X) ? -1 : 1;
+	} else if ((p.x1 == CENTER_X) && (p.x2 == CENTER_X)) {
+		dy = (p.y1 + p.y2 < 2 * CENTER_Y) ? -1 : 1;
+	}
+}
+
+/*
+ * Arms of the cross shapes move outwards by exactly the gap, everything else stays in place
+ */
+void TestGapShapes() {
+	const int32_t sizes[] = {1, 16, 100, 1080};
+	const int32_t gaps[] = {1, 7, 50};
+
+	for (int32_t shape = 1; shape <= 7; shape++) {
+		for (int32_t size : sizes) {
+			for (int32_t penWidth = 1; penWidth <= 4; penWidth++) {
+				for (int32_t gap : gaps) {
+					Reticle still = {};
+					Reticle spread = {};
+					BuildReticle(still, shape, CENTER_X, CENTER_Y, size, penWidth, 0);
+					BuildReticle(spread, shape, CENTER_X, CENTER_Y, size, penWidth, gap);
+					CHECK(still.primitives.size() == spread.primitives.size());
+					if (still.primitives.size() != spread.primitives.size()) {
+						continue;
+					}
+
+					int32_t arms = 0;
+					for (size_t i = 0; i < still.primitives.size(); i++) {
+						const Primitive &a = still.primitives[i];
+						Primitive expected = a;
+						float dx;
+						float dy;
+						ArmDirection(a, dx, dy);
+						if ((dx != 0) || (dy != 0)) {
+							expected.x1 += dx * gap;
+							expected.x2 += dx * gap;
+							expected.y1 += dy * gap;
+							expected.y2 += dy * gap;
+							arms++;
+						}
+						CHECK(SamePrimitive(spread.primitives[i], expected));
+					}
+					CHECK(arms == 4);
+				}
+			}
+		}
+	}
+}
+
+/*
+ * Shapes without a gap ignore the spread
+ */
+void TestOtherShapes() {
+	for (int32_t shape = 0; shape < NUM_SHAPES; shape++) {
+		if ((shape >= 1) && (shape <= 7)) {
+			continue;
+		}
+
+		Reticle still = {};
+		Reticle spread = {};
+		BuildReticle(still, shape, CENTER_X, CENTER_Y, 100, 2, 0);
+		BuildReticle(spread, shape, CENTER_X, CENTER_Y, 100, 2, 25);
+		CHECK(!still.primitives.empty());
+		CHECK(still.primitives.size() == spread.primitives.size());
+		for (size_t i = 0; (i < still.primitives.size()) && (i < spread.primitives.size()); i++) {
+			CHECK(SamePrimitive(still.primitives[i], spread.primitives[i]));
+		}
+	}
+
+	// unknown shapes draw nothing
+	Reticle none = {};
+	BuildReticle(none, NUM_SHAPES, CENTER_X, CENTER_Y, 100, 2, 25);
+	CHECK(none.primitives.empty());
+}
+
+int main() {
+	TestGapShapes();
+	TestOtherShapes();
+	return TestResult("test_reticle");
+}
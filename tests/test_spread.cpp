@@ -0,0 +1,231 @@
+/*
+ * Tests of the raw mouse input queue and the spread filter, replaying input traces
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spread.h"
+#include "test.h"
+
+#define TICK_TIME	10											// spread update interval in milliseconds, as used by the app
+
+// synthetic raw mouse movement, generated to resemble typical input
+struct TraceEvent {
+	int64_t time;												// time in microseconds
+	MouseMove move;												// relative movement
+};
+
+// result of replaying a trace
+struct Replay {
+	std::vector<int32_t> gaps;									// quantized gap after each tick
+	int32_t redraws;											// number of gap changes causing a redraw
+};
+
+InputQueue queue = {};
+
+/*
+ * Load input trace
+ */
+std::vector<TraceEvent> LoadTrace(const char *name) {
+	std::vector<TraceEvent> trace;
+	std::string path = std::string(TRACE_DIR) + "/" + name + ".trace";
+	char line[256];
+
+	FILE *f = fopen(path.c_str(), "r");
+	if (!f) {
+		fprintf(stderr, "could not open %s\n", path.c_str());
+		return trace;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		TraceEvent event;
+		long long time;
+		if ((line[0] != '#') && (sscanf(line, "%lld %d %d", &time, &event.move.dx, &event.move.dy) == 3)) {
+			event.time = time;
+			trace.push_back(event);
+		}
+	}
+	fclose(f);
+	return trace;
+}
+
+/*
+ * Replay trace through the input queue and spread filter, ticking every TICK_TIME milliseconds
+ */
+Replay ReplayTrace(const std::vector<TraceEvent> &trace, int32_t duration) {
+	Replay replay = {};
+	SpreadFilter filter = {};
+	size_t next = 0;
+
+	for (int32_t tick = 1; tick * TICK_TIME <= duration; tick++) {
+		// input thread queues the movements received until this tick
+		while ((next < trace.size()) && (trace[next].time < (int64_t)tick * TICK_TIME * 1000)) {
+			CHECK(PushMouseMove(queue, trace[next].move));
+			next++;
+		}
+
+		// UI thread updates the spread
+		if (StepSpread(filter, DrainMouseMoves(queue), TICK_TIME)) {
+			replay.redraws++;
+		}
+		replay.gaps.push_back(filter.gap);
+	}
+	return replay;
+}
+
+/*
+ * Queue operations within a single thread
+ */
+void TestQueue() {
+	MouseMove move;
+
+	CHECK(!PopMouseMove(queue, move));
+
+	// fill queue completely, wrapping around the ring buffer several times
+	for (int32_t round = 0; round < 3; round++) {
+		for (int32_t i = 0; i < INPUT_QUEUE_SIZE; i++) {
+			MouseMove in = {i, -i};
+			CHECK(PushMouseMove(queue, in));
+		}
+
+		MouseMove overflow = {1, 1};
+		CHECK(!PushMouseMove(queue, overflow));
+
+		for (int32_t i = 0; i < INPUT_QUEUE_SIZE; i++) {
+			CHECK(PopMouseMove(queue, move));
+			CHECK((move.dx == i) && (move.dy == -i));
+		}
+		CHECK(!PopMouseMove(queue, move));
+	}
+
+	// distance of drained movements
+	MouseMove a = {3, 4};
+	MouseMove b = {-6, 8};
+	PushMouseMove(queue, a);
+	PushMouseMove(queue, b);
+	CHECK(DrainMouseMoves(queue) == 15.0);
+	CHECK(DrainMouseMoves(queue) == 0.0);
+}
+
+/*
+ * Queue passing movements from a producer thread to a consumer thread
+ */
+void TestQueueThreads() {
+	const int32_t count = 1000000;
+	int32_t received = 0;
+	bool ordered = true;
+
+	std::thread producer([count]() {
+		for (int32_t i = 0; i < count; i++) {
+			MouseMove move = {i, 1};
+			while (!PushMouseMove(queue, move)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	MouseMove move;
+	while (received < count) {
+		if (PopMouseMove(queue, move)) {
+			ordered = ordered && (move.dx == received) && (move.dy == 1);
+			received++;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	CHECK(ordered);
+	CHECK(!PopMouseMove(queue, move));
+}
+
+/*
+ * Spread filter steps
+ */
+void TestFilter() {
+	SpreadFilter filter = {};
+
+	// no elapsed time, no change
+	CHECK(!StepSpread(filter, 1000.0, 0.0));
+	CHECK(filter.gap == 0);
+
+	// spread is limited
+	CHECK(StepSpread(filter, 1000000.0, TICK_TIME));
+	CHECK(filter.gap == MAX_SPREAD);
+
+	// recovers exponentially without movement
+	StepSpread(filter, 0.0, SPREAD_RECOVERY_TIME);
+	CHECK(filter.gap == (int32_t)(MAX_SPREAD * exp(-1.0) + 0.5));
+
+	// unchanged quantized gap is not reported
+	ResetSpread(filter);
+	CHECK(!StepSpread(filter, 0.0, TICK_TIME));
+}
+
+/*
+ * Fast flick widens the gap to the maximum, which recovers after the movement
+ */
+void TestFlickTrace() {
+	std::vector<TraceEvent> trace = LoadTrace("flick");
+	CHECK(!trace.empty());
+
+	Replay replay = ReplayTrace(trace, 1200);
+
+	// widened within the first tick, held during the flick
+	CHECK(replay.gaps[0] == MAX_SPREAD);
+	for (int32_t tick = 0; tick < 15; tick++) {
+		CHECK(replay.gaps[tick] == MAX_SPREAD);
+	}
+
+	// recovered within 800 ms after the flick
+	for (size_t tick = 95; tick < replay.gaps.size(); tick++) {
+		CHECK(replay.gaps[tick] == 0);
+	}
+
+	// a redraw per pixel of recovery at most
+	CHECK(replay.redraws <= MAX_SPREAD + 2);
+}
+
+/*
+ * Steady tracking keeps a small, stable gap
+ */
+void TestTrackingTrace() {
+	std::vector<TraceEvent> trace = LoadTrace("tracking");
+	CHECK(!trace.empty());
+
+	Replay replay = ReplayTrace(trace, 1000);
+
+	for (size_t tick = 5; tick < replay.gaps.size(); tick++) {
+		CHECK((replay.gaps[tick] >= 2) && (replay.gaps[tick] <= 6));
+	}
+	CHECK(replay.redraws < 40);
+}
+
+/*
+ * Sensor jitter does not widen the gap
+ */
+void TestJitterTrace() {
+	std::vector<TraceEvent> trace = LoadTrace("jitter");
+	CHECK(!trace.empty());
+
+	Replay replay = ReplayTrace(trace, 1000);
+
+	for (int32_t gap : replay.gaps) {
+		CHECK(gap == 0);
+	}
+}
+
+int main() {
+	TestQueue();
+	TestQueueThreads();
+	TestFilter();
+	TestFlickTrace();
+	TestTrackingTrace();
+	TestJitterTrace();
+	return TestResult("test_spread");
+}
@@ -0,0 +1,409 @@
+/*
+ * Tests of the tile bookkeeping and the sparse tile store
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "test.h"
+#include "tiles.h"
+
+#define SCREEN_WIDTH	3840										// 4K screen, 60 x 34 tiles (last row partial)
+#define SCREEN_HEIGHT	2160
+
+/*
+ * Check that the tile set contains exactly the given tiles
+ */
+bool HasTiles(const TileGrid &grid, const TileMask &mask, std::vector<int32_t> expected) {
+	std::vector<int32_t> marked = mask.marked;
+	std::sort(marked.begin(), marked.end());
+	std::sort(expected.begin(), expected.end());
+
+	size_t flagged = 0;
+	for (uint8_t flag : mask.flags) {
+		flagged += flag;
+	}
+	return (marked == expected) && (flagged == expected.size()) && (mask.flags.size() == (size_t)grid.tilesX * grid.tilesY);
+}
+
+/*
+ * Index of the tile containing a pixel
+ */
+int32_t TileAt(const TileGrid &grid, int32_t x, int32_t y) {
+	return (y / TILE_SIZE) * grid.tilesX + (x / TILE_SIZE);
+}
+
+/*
+ * Tile grid and tile rectangles
+ */
+void TestGrid() {
+	TileGrid grid;
+	InitTileGrid(grid, SCREEN_WIDTH, SCREEN_HEIGHT);
+	CHECK((grid.tilesX == 60) && (grid.tilesY == 34));
+
+	TileRect first = GetTileRect(grid, 0);
+	CHECK((first.left == 0) && (first.top == 0) && (first.right == 64) && (first.bottom == 64));
+
+	// last row is clipped to the screen
+	TileRect last = GetTileRect(grid, grid.tilesX * grid.tilesY - 1);
+	CHECK((last.left == 3776) && (last.top == 2112) && (last.right == 3840) && (last.bottom == 2160));
+}
+
+/*
+ * Tile sets are cleared proportional to their size, without losing flags
+ */
+void TestMask() {
+	TileGrid grid;
+	InitTileGrid(grid, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileMask mask;
+	InitTileMask(mask, grid);
+
+	MarkTile(mask, 5);
+	MarkTile(mask, 5);
+	MarkTile(mask, 7);
+	CHECK(HasTiles(grid, mask, {5, 7}));
+
+	ClearTileMask(mask);
+	CHECK(HasTiles(grid, mask, {}));
+}
+
+/*
+ * Horizontal, vertical and diagonal lines only mark the tiles they cross
+ */
+void TestLines() {
+	TileGrid grid;
+	InitTileGrid(grid, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileMask mask;
+	InitTileMask(mask, grid);
+
+	// horizontal line within a tile row
+	MarkLine(grid, mask, 10, 100, 200, 100, 2);
+	CHECK(HasTiles(grid, mask, {60, 61, 62, 63}));
+
+	// padding reaches into the tile row above
+	ClearTileMask(mask);
+	MarkLine(grid, mask, 10, 65, 20, 65, 2);
+	CHECK(HasTiles(grid, mask, {0, 60}));
+
+	// vertical line within a tile column
+	ClearTileMask(mask);
+	MarkLine(grid, mask, 1920, 0, 1920, 2159, 0);
+	CHECK((int32_t)mask.marked.size() == grid.tilesY);
+	for (int32_t index : mask.marked) {
+		CHECK(index % grid.tilesX == 30);
+	}
+
+	// diagonal line only marks the tiles along the diagonal
+	ClearTileMask(mask);
+	MarkLine(grid, mask, 32, 32, 32 + 10 * TILE_SIZE, 32 + 10 * TILE_SIZE, 1);
+	for (int32_t index : mask.marked) {
+		int32_t tileX = index % grid.tilesX;
+		int32_t tileY = index / grid.tilesX;
+		CHECK((tileX - tileY >= -1) && (tileX - tileY <= 1));
+	}
+	CHECK(mask.flags[TileAt(grid, 32, 32)] && mask.flags[TileAt(grid, 32 + 10 * TILE_SIZE, 32 + 10 * TILE_SIZE)]);
+	CHECK(mask.marked.size() <= 3 * 11);
+
+	// lines beyond the screen are clipped
+	ClearTileMask(mask);
+	MarkLine(grid, mask, -500, -10, -100, -10, 2);
+	MarkLine(grid, mask, 5000, 100, 6000, 100, 2);
+	CHECK(HasTiles(grid, mask, {}));
+	MarkLine(grid, mask, -500, 2150, 5000, 2150, 2);
+	CHECK((int32_t)mask.marked.size() == grid.tilesX);
+}
+
+/*
+ * Circle outlines leave the tiles inside the circle unmarked
+ */
+void TestEllipse() {
+	TileGrid grid;
+	InitTileGrid(grid, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileMask mask;
+	InitTileMask(mask, grid);
+
+	// circle with a radius of 1000 pixels around the screen center
+	MarkEllipse(grid, mask, 920, 80, 2000, 2000, 2);
+	CHECK(!mask.flags[TileAt(grid, 1920, 1080)]);
+	CHECK(mask.flags[TileAt(grid, 920, 1080)] && mask.flags[TileAt(grid, 2919, 1080)]);
+	CHECK(mask.flags[TileAt(grid, 1920, 80)] && mask.flags[TileAt(grid, 1920, 2079)]);
+	CHECK(!mask.flags[TileAt(grid, 0, 0)]);
+
+	// far fewer tiles than the bounding box
+	CHECK(mask.marked.size() < (size_t)(32 * 32) / 4);
+
+	// non-circular ellipses mark their bounding box
+	ClearTileMask(mask);
+	MarkEllipse(grid, mask, 10, 10, 100, 20, 0);
+	CHECK(HasTiles(grid, mask, {0, 1}));
+}
+
+/*
+ * Boxes and primitives
+ */
+void TestPrimitives() {
+	TileGrid grid;
+	InitTileGrid(grid, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileMask mask;
+	InitTileMask(mask, grid);
+
+	MarkBox(grid, mask, 60, 60, 70, 70);
+	CHECK(HasTiles(grid, mask, {0, 1, 60, 61}));
+
+	// rectangle outline does not mark the tiles inside
+	ClearTileMask(mask);
+	Primitive rectangle = {PRIMITIVE_RECTANGLE, 10, 10, 300, 300, true};
+	MarkPrimitive(grid, mask, rectangle, 1);
+	CHECK(!mask.flags[TileAt(grid, 160, 160)]);
+	CHECK(mask.flags[TileAt(grid, 10, 10)] && mask.flags[TileAt(grid, 310, 310)]);
+
+	// filled rectangle marks everything
+	ClearTileMask(mask);
+	Primitive filled = {PRIMITIVE_FILLED_RECTANGLE, 10, 10, 300, 300, true};
+	MarkPrimitive(grid, mask, filled, 1);
+	CHECK(mask.flags[TileAt(grid, 160, 160)]);
+	CHECK(mask.marked.size() == 25);
+}
+
+/*
+ * Primitives are binned into the tiles they touch
+ */
+void TestBins() {
+	TileGrid grid;
+	InitTileGrid(grid, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileBins bins;
+	InitTileBins(bins, grid);
+
+	// full-screen cross
+	Reticle reticle = {};
+	reticle.antiAlias = false;
+	AddLine(reticle, 0, 1100, 3839, 1100);
+	AddLine(reticle, 1950, 0, 1950, 2159);
+	BinPrimitives(grid, reticle, 2, bins);
+
+	CHECK(bins.inked.marked.size() == (size_t)(grid.tilesX + grid.tilesY - 1));
+	std::vector<uint32_t> &center = bins.primitives[TileAt(grid, 1950, 1100)];
+	CHECK((center.size() == 2) && (center[0] == 0) && (center[1] == 1));
+	CHECK(bins.primitives[TileAt(grid, 0, 1100)].size() == 1);
+
+	TileRect bounds = GetTileBounds(grid, bins.inked);
+	CHECK((bounds.left == 0) && (bounds.top == 0) && (bounds.right == 3840) && (bounds.bottom == 2160));
+
+	// rebinning drops the primitives of the last crosshairs
+	Reticle dot = {};
+	AddFilledRectangle(dot, 1949, 1099, 2, 2);
+	BinPrimitives(grid, dot, 2, bins);
+	CHECK(HasTiles(grid, bins.inked, {TileAt(grid, 1950, 1100)}));
+	CHECK(bins.primitives[TileAt(grid, 0, 1100)].empty());
+	CHECK(bins.primitives[TileAt(grid, 1950, 1100)].size() == 1);
+
+	bounds = GetTileBounds(grid, bins.inked);
+	CHECK((bounds.left == 1920) && (bounds.top == 1088) && (bounds.right == 1984) && (bounds.bottom == 1152));
+
+	// no crosshairs, no tiles
+	Reticle empty = {};
+	BinPrimitives(grid, empty, 2, bins);
+	bounds = GetTileBounds(grid, bins.inked);
+	CHECK(bins.inked.marked.empty() && (bounds.right == 0) && (bounds.bottom == 0));
+}
+
+/*
+ * Tiles are allocated on demand and composed into dense buffers
+ */
+void TestStore() {
+	TileStore store = {};
+	InitTileStore(store, 200, 100);
+	CHECK((store.grid.tilesX == 4) && (store.grid.tilesY == 2) && (store.allocatedTiles == 0));
+
+	uint32_t *tile = AcquireTile(store, 1);
+	CHECK(tile && (store.allocatedTiles == 1));
+	CHECK(AcquireTile(store, 1) == tile);
+	for (int32_t i = 0; i < TILE_PIXELS; i++) {
+		tile[i] = 0xff000000 | (uint32_t)i;
+	}
+
+	tile = AcquireTile(store, 7);
+	CHECK(tile && (store.allocatedTiles == 2));
+	for (int32_t i = 0; i < TILE_PIXELS; i++) {
+		tile[i] = 0x80000000 | (uint32_t)i;
+	}
+
+	// compose whole screen
+	std::vector<uint32_t> pixels(200 * 100, 0xdeadbeef);
+	TileRect screen = {0, 0, 200, 100};
+	ComposeTiles(store, screen, pixels.data(), 200, 0, 0);
+	CHECK(pixels[0] == 0);
+	CHECK(pixels[64] == 0xff000000);
+	CHECK(pixels[5 * 200 + 70] == (0xff000000 | (5 * TILE_SIZE + 6)));
+	CHECK(pixels[99 * 200 + 199] == (0x80000000 | (35 * TILE_SIZE + 7)));
+	CHECK(pixels[99 * 200 + 0] == 0);
+
+	// compose part of the screen into a smaller buffer
+	std::vector<uint32_t> part(10 * 10, 0xdeadbeef);
+	TileRect area = {60, 0, 70, 10};
+	ComposeTiles(store, area, part.data(), 10, 60, 0);
+	CHECK((part[0] == 0) && (part[3] == 0));
+	CHECK(part[4] == 0xff000000);
+	CHECK(part[9 * 10 + 9] == (0xff000000 | (9 * TILE_SIZE + 5)));
+
+	// released tiles are transparent
+	ReleaseTile(store, 1);
+	ReleaseTile(store, 1);
+	CHECK(store.allocatedTiles == 1);
+	ComposeTiles(store, screen, pixels.data(), 200, 0, 0);
+	CHECK(pixels[5 * 200 + 70] == 0);
+
+	FreeTileStore(store);
+	CHECK(store.allocatedTiles == 0);
+}
+
+/*
+ * Fill the tiles with opaque pixels, counting the rasterized tiles (UpdateTiles callback)
+ */
+void FillTile(void *context, uint32_t *pixels, const TileRect &, const Reticle &, const std::vector<uint32_t> &) {
+	(*(int32_t*)context)++;
+	for (int32_t i = 0; i < TILE_PIXELS; i++) {
+		pixels[i] = 0xffffffff;
+	}
+}
+
+/*
+ * Per-frame tile updates only rasterize changed tiles, and free the tiles without geometry
+ */
+void TestUpdate() {
+	TileStore store = {};
+	InitTileStore(store, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileBins bins;
+	InitTileBins(bins, store.grid);
+	TileMask shown;
+	TileMask dirty;
+	InitTileMask(shown, store.grid);
+	InitTileMask(dirty, store.grid);
+	int32_t rasterized = 0;
+
+	// full-screen cross with a gap, all tiles are new
+	Reticle cross = {};
+	AddLine(cross, 0, 1100, 1940, 1100);
+	AddLine(cross, 1960, 1100, 3839, 1100);
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+	CHECK((rasterized == (int32_t)bins.inked.marked.size()) && (shown.marked.size() == bins.inked.marked.size()));
+	CHECK(dirty.marked.size() == shown.marked.size());
+	CHECK(store.allocatedTiles == shown.marked.size());
+
+	// same geometry again, nothing changes
+	rasterized = 0;
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+	CHECK((rasterized == 0) && dirty.marked.empty() && (shown.marked.size() == bins.inked.marked.size()));
+
+	// unless everything has to be redrawn
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, true, FillTile, &rasterized, shown, dirty);
+	CHECK((rasterized == (int32_t)bins.inked.marked.size()) && (dirty.marked.size() == shown.marked.size()));
+
+	// wider gap, only the tiles around the center change
+	rasterized = 0;
+	Reticle spread = {};
+	AddLine(spread, 0, 1100, 1930, 1100);
+	AddLine(spread, 1970, 1100, 3839, 1100);
+	BinPrimitives(store.grid, spread, 2, bins);
+	UpdateTiles(store, bins, spread, false, FillTile, &rasterized, shown, dirty);
+	CHECK(HasTiles(store.grid, dirty, {TileAt(store.grid, 1930, 1100)}));
+	CHECK(rasterized == 1);
+
+	// different shape, the tiles of the cross are freed and dirty, and transparent
+	Reticle dot = {};
+	AddFilledRectangle(dot, 100, 100, 2, 2);
+	BinPrimitives(store.grid, dot, 2, bins);
+	UpdateTiles(store, bins, dot, false, FillTile, &rasterized, shown, dirty);
+	int32_t freed = TileAt(store.grid, 0, 1100);
+	CHECK(dirty.flags[freed] && dirty.flags[TileAt(store.grid, 1950, 1100)] && dirty.flags[TileAt(store.grid, 100, 100)]);
+	CHECK(dirty.marked.size() == (size_t)store.grid.tilesX + 1);
+	CHECK(!store.tiles[freed] && store.drawn[freed].empty());
+	CHECK(HasTiles(store.grid, shown, {TileAt(store.grid, 100, 100)}) && (store.allocatedTiles == 1));
+
+	std::vector<uint32_t> pixels(TILE_PIXELS, 0xdeadbeef);
+	ComposeTiles(store, GetTileRect(store.grid, freed), pixels.data(), TILE_SIZE, 0, 1088);
+	CHECK(std::count(pixels.begin(), pixels.end(), 0u) == TILE_PIXELS);
+
+	FreeTileStore(store);
+}
+
+/*
+ * Packed tiles are rasterized into the memory given per frame, dirty tiles still only depend on the geometry
+ */
+void TestPackedUpdate() {
+	TileStore store = {};
+	InitTileStore(store, SCREEN_WIDTH, SCREEN_HEIGHT);
+	TileBins bins;
+	InitTileBins(bins, store.grid);
+	TileMask shown;
+	TileMask dirty;
+	InitTileMask(shown, store.grid);
+	InitTileMask(dirty, store.grid);
+	int32_t rasterized = 0;
+
+	// separately allocated tiles are freed when switching to packed memory
+	Reticle cross = {};
+	AddLine(cross, 0, 1100, 1940, 1100);
+	AddLine(cross, 1960, 1100, 3839, 1100);
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+	size_t tileCount = bins.inked.marked.size();
+	CHECK(store.allocatedTiles == tileCount);
+
+	std::vector<uint32_t> frames[2];
+	frames[0].assign(tileCount * TILE_PIXELS, 0);
+	frames[1].assign(tileCount * TILE_PIXELS, 0);
+	SetTileMemory(store, frames[0].data(), tileCount);
+	CHECK(store.allocatedTiles == 0);
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+
+	// the same geometry in another frame is rasterized again, but not dirty
+	rasterized = 0;
+	SetTileMemory(store, frames[1].data(), tileCount);
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+	CHECK(((size_t)rasterized == tileCount) && dirty.marked.empty());
+
+	// tiles are packed in the order of the shown tiles
+	bool packed = (shown.marked.size() == tileCount);
+	for (size_t i = 0; (i < shown.marked.size()) && packed; i++) {
+		packed = (store.tiles[shown.marked[i]] == frames[1].data() + i * TILE_PIXELS);
+	}
+	CHECK(packed && (frames[1][0] == 0xffffffff) && (frames[1].back() == 0xffffffff));
+
+	// tiles beyond the packed memory are transparent and dirty
+	SetTileMemory(store, frames[0].data(), tileCount - 1);
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+	int32_t last = bins.inked.marked.back();
+	CHECK((shown.marked.size() == tileCount - 1) && !shown.flags[last] && !store.tiles[last]);
+	CHECK(HasTiles(store.grid, dirty, {last}));
+
+	// switching back to separately allocated tiles does not free the packed memory
+	SetTileMemory(store, NULL, 0);
+	BinPrimitives(store.grid, cross, 2, bins);
+	UpdateTiles(store, bins, cross, false, FillTile, &rasterized, shown, dirty);
+	CHECK((store.allocatedTiles == tileCount) && (shown.marked.size() == tileCount) && store.tiles[last]);
+
+	FreeTileStore(store);
+}
+
+int main() {
+	TestGrid();
+	TestMask();
+	TestLines();
+	TestEllipse();
+	TestPrimitives();
+	TestBins();
+	TestStore();
+	TestUpdate();
+	TestPackedUpdate();
+	return TestResult("test_tiles");
+}
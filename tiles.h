@@ -0,0 +1,581 @@
+/*
+ * Tiled sparse crosshairs surface
+ *
+ * The screen is divided into tiles of TILE_SIZE x TILE_SIZE pixels. The
+ * drawing primitives of the crosshairs are binned into the tiles they touch,
+ * and only those tiles are allocated, rasterized and transferred. Free of
+ * Windows dependencies.
+ */
+
+#ifndef TILES_H
+#define TILES_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#define TILE_SIZE				64								// width and height of a tile in pixels
+#define TILE_PIXELS				(TILE_SIZE * TILE_SIZE)			// number of pixels of a tile
+
+// crosshairs drawing primitive types
+enum PrimitiveType {
+	PRIMITIVE_LINE,												// line from (x1, y1) to (x2, y2)
+	PRIMITIVE_ELLIPSE,											// ellipse outline within (x, y, width, height)
+	PRIMITIVE_RECTANGLE,										// rectangle outline (x, y, width, height)
+	PRIMITIVE_FILLED_RECTANGLE									// filled rectangle (x, y, width, height)
+};
+
+// crosshairs drawing primitive
+struct Primitive {
+	PrimitiveType type;											// primitive type
+	float x1;													// start X coordinate or left edge
+	float y1;													// start Y coordinate or top edge
+	float x2;													// end X coordinate or width
+	float y2;													// end Y coordinate or height
+	bool antiAlias;												// flag for drawing with antialiasing
+};
+
+// geometry of the selected crosshairs shape
+struct Reticle {
+	std::vector<Primitive> primitives;							// drawing primitives
+	bool antiAlias;												// antialiasing flag for subsequently added primitives
+};
+
+// rectangle in pixels, right and bottom are exclusive
+struct TileRect {
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+};
+
+// division of the screen into tiles
+struct TileGrid {
+	int32_t width;												// width in pixels
+	int32_t height;												// height in pixels
+	int32_t tilesX;												// number of tile columns
+	int32_t tilesY;												// number of tile rows
+};
+
+// set of tiles
+struct TileMask {
+	std::vector<uint8_t> flags;									// flag per tile
+	std::vector<int32_t> marked;								// indices of the flagged tiles
+};
+
+// tiles touched by the crosshairs, and the primitives touching each of them
+struct TileBins {
+	TileMask inked;												// tiles containing geometry
+	TileMask scratch;											// tiles touched by a single primitive
+	std::vector<std::vector<uint32_t>> primitives;				// indices of the primitives per tile
+	float pad;													// padding of the primitives in pixels
+};
+
+// sparse pixel storage, only tiles containing geometry are allocated, or packed into memory provided per frame
+struct TileStore {
+	TileGrid grid;												// tile grid
+	std::vector<uint32_t*> tiles;								// TILE_SIZE x TILE_SIZE pixels per tile, NULL if empty
+	std::vector<std::vector<Primitive>> drawn;					// primitives rasterized into each tile, clipped to the tile
+	size_t allocatedTiles;										// number of separately allocated tiles
+	uint32_t *packed;											// memory for the tiles of the next frame, NULL to allocate each tile
+	size_t packedCapacity;										// number of tiles fitting into the packed memory
+};
+
+// rasterizes the primitives touching a tile into its pixels, which are transparent before
+typedef void (*RasterizeTile)(void *context, uint32_t *pixels, const TileRect &rect, const Reticle &reticle, const std::vector<uint32_t> &primitives);
+
+/*
+ * Add line to crosshairs geometry
+ */
+inline void AddLine(Reticle &reticle, float x1, float y1, float x2, float y2) {
+	Primitive primitive = {PRIMITIVE_LINE, x1, y1, x2, y2, reticle.antiAlias};
+	reticle.primitives.push_back(primitive);
+}
+
+/*
+ * Add ellipse outline to crosshairs geometry
+ */
+inline void AddEllipse(Reticle &reticle, float x, float y, float width, float height) {
+	Primitive primitive = {PRIMITIVE_ELLIPSE, x, y, width, height, reticle.antiAlias};
+	reticle.primitives.push_back(primitive);
+}
+
+/*
+ * Add rectangle outline to crosshairs geometry
+ */
+inline void AddRectangle(Reticle &reticle, float x, float y, float width, float height) {
+	Primitive primitive = {PRIMITIVE_RECTANGLE, x, y, width, height, reticle.antiAlias};
+	reticle.primitives.push_back(primitive);
+}
+
+/*
+ * Add filled rectangle to crosshairs geometry
+ */
+inline void AddFilledRectangle(Reticle &reticle, float x, float y, float width, float height) {
+	Primitive primitive = {PRIMITIVE_FILLED_RECTANGLE, x, y, width, height, reticle.antiAlias};
+	reticle.primitives.push_back(primitive);
+}
+
+/*
+ * Divide screen into tiles
+ */
+inline void InitTileGrid(TileGrid &grid, int32_t width, int32_t height) {
+	grid.width = width;
+	grid.height = height;
+	grid.tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	grid.tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+/*
+ * Get pixel rectangle of tile, clipped to the screen
+ */
+inline TileRect GetTileRect(const TileGrid &grid, int32_t index) {
+	TileRect rect;
+	rect.left = (index % grid.tilesX) * TILE_SIZE;
+	rect.top = (index / grid.tilesX) * TILE_SIZE;
+	rect.right = (rect.left + TILE_SIZE > grid.width) ? grid.width : rect.left + TILE_SIZE;
+	rect.bottom = (rect.top + TILE_SIZE > grid.height) ? grid.height : rect.top + TILE_SIZE;
+	return rect;
+}
+
+/*
+ * Create empty tile set for tile grid
+ */
+inline void InitTileMask(TileMask &mask, const TileGrid &grid) {
+	mask.flags.assign((size_t)grid.tilesX * grid.tilesY, 0);
+	mask.marked.clear();
+}
+
+/*
+ * Add tile to tile set
+ */
+inline void MarkTile(TileMask &mask, int32_t index) {
+	if (!mask.flags[index]) {
+		mask.flags[index] = 1;
+		mask.marked.push_back(index);
+	}
+}
+
+/*
+ * Remove all tiles from tile set, proportional to the number of flagged tiles
+ */
+inline void ClearTileMask(TileMask &mask) {
+	for (int32_t index : mask.marked) {
+		mask.flags[index] = 0;
+	}
+	mask.marked.clear();
+}
+
+/*
+ * Mark the tiles of a tile row overlapping the horizontal pixel range [left, right]
+ */
+inline void MarkTileSpan(const TileGrid &grid, TileMask &mask, int32_t tileRow, float left, float right) {
+	if ((tileRow < 0) || (tileRow >= grid.tilesY) || (right < 0) || (left >= grid.width)) {
+		return;
+	}
+
+	int32_t firstTile = (left < 0) ? 0 : (int32_t)left / TILE_SIZE;
+	int32_t lastTile = (right >= grid.width) ? grid.tilesX - 1 : (int32_t)right / TILE_SIZE;
+	for (int32_t tileX = firstTile; tileX <= lastTile; tileX++) {
+		MarkTile(mask, tileRow * grid.tilesX + tileX);
+	}
+}
+
+/*
+ * Get the tile rows overlapping the vertical pixel range [top, bottom], returns false if there are none
+ */
+inline bool GetTileRows(const TileGrid &grid, float top, float bottom, int32_t &firstRow, int32_t &lastRow) {
+	if ((bottom < 0) || (top >= grid.height)) {
+		return false;
+	}
+
+	firstRow = (top < 0) ? 0 : (int32_t)top / TILE_SIZE;
+	lastRow = (bottom >= grid.height) ? grid.tilesY - 1 : (int32_t)bottom / TILE_SIZE;
+	return true;
+}
+
+/*
+ * Mark the tiles overlapping the pixel box [left, right] x [top, bottom]
+ */
+inline void MarkBox(const TileGrid &grid, TileMask &mask, float left, float top, float right, float bottom) {
+	int32_t firstRow;
+	int32_t lastRow;
+
+	if (GetTileRows(grid, top, bottom, firstRow, lastRow)) {
+		for (int32_t tileY = firstRow; tileY <= lastRow; tileY++) {
+			MarkTileSpan(grid, mask, tileY, left, right);
+		}
+	}
+}
+
+/*
+ * Mark the tiles touched by a line drawn with the given padding
+ */
+inline void MarkLine(const TileGrid &grid, TileMask &mask, float x1, float y1, float x2, float y2, float pad) {
+	int32_t firstRow;
+	int32_t lastRow;
+
+	if (!GetTileRows(grid, ((y1 < y2) ? y1 : y2) - pad, ((y1 > y2) ? y1 : y2) + pad, firstRow, lastRow)) {
+		return;
+	}
+
+	for (int32_t tileY = firstRow; tileY <= lastRow; tileY++) {
+		float left;
+		float right;
+
+		if (y1 == y2) {
+			// horizontal line covers the same range in every row
+			left = (x1 < x2) ? x1 : x2;
+			right = (x1 > x2) ? x1 : x2;
+		} else {
+			// clip line to the padded tile row
+			float t1 = ((float)(tileY * TILE_SIZE) - pad - y1) / (y2 - y1);
+			float t2 = ((float)((tileY + 1) * TILE_SIZE) + pad - y1) / (y2 - y1);
+			t1 = (t1 < 0) ? 0 : ((t1 > 1) ? 1 : t1);
+			t2 = (t2 < 0) ? 0 : ((t2 > 1) ? 1 : t2);
+
+			float xa = x1 + t1 * (x2 - x1);
+			float xb = x1 + t2 * (x2 - x1);
+			left = (xa < xb) ? xa : xb;
+			right = (xa > xb) ? xa : xb;
+		}
+		MarkTileSpan(grid, mask, tileY, left - pad, right + pad);
+	}
+}
+
+/*
+ * Mark the tiles touched by an ellipse outline drawn with the given padding
+ */
+inline void MarkEllipse(const TileGrid &grid, TileMask &mask, float x, float y, float width, float height, float pad) {
+	if (width != height) {
+		// only circles are drawn, use the bounding box for anything else
+		MarkBox(grid, mask, x - pad, y - pad, x + width + pad, y + height + pad);
+		return;
+	}
+
+	// mark tiles intersecting the ring around the circle outline
+	float radius = width / 2;
+	float cx = x + radius;
+	float cy = y + radius;
+	float inner = (radius > pad) ? radius - pad : 0;
+	float outer = radius + pad;
+	int32_t firstRow;
+	int32_t lastRow;
+
+	if (!GetTileRows(grid, cy - outer, cy + outer, firstRow, lastRow) || (cx + outer < 0) || (cx - outer >= grid.width)) {
+		return;
+	}
+
+	int32_t firstColumn = (cx - outer < 0) ? 0 : (int32_t)(cx - outer) / TILE_SIZE;
+	int32_t lastColumn = (cx + outer >= grid.width) ? grid.tilesX - 1 : (int32_t)(cx + outer) / TILE_SIZE;
+
+	for (int32_t tileY = firstRow; tileY <= lastRow; tileY++) {
+		float top = (float)(tileY * TILE_SIZE);
+		float bottom = top + TILE_SIZE;
+
+		for (int32_t tileX = firstColumn; tileX <= lastColumn; tileX++) {
+			float left = (float)(tileX * TILE_SIZE);
+			float right = left + TILE_SIZE;
+
+			// nearest and farthest distance between circle center and tile
+			float nx = (cx < left) ? left - cx : ((cx > right) ? cx - right : 0);
+			float ny = (cy < top) ? top - cy : ((cy > bottom) ? cy - bottom : 0);
+			float fx = (cx - left > right - cx) ? cx - left : right - cx;
+			float fy = (cy - top > bottom - cy) ? cy - top : bottom - cy;
+
+			if ((nx * nx + ny * ny <= outer * outer) && (fx * fx + fy * fy >= inner * inner)) {
+				MarkTile(mask, tileY * grid.tilesX + tileX);
+			}
+		}
+	}
+}
+
+/*
+ * Mark the tiles touched by a drawing primitive drawn with the given padding
+ */
+inline void MarkPrimitive(const TileGrid &grid, TileMask &mask, const Primitive &p, float pad) {
+	switch (p.type) {
+		case PRIMITIVE_LINE:
+			MarkLine(grid, mask, p.x1, p.y1, p.x2, p.y2, pad);
+			break;
+
+		case PRIMITIVE_ELLIPSE:
+			MarkEllipse(grid, mask, p.x1, p.y1, p.x2, p.y2, pad);
+			break;
+
+		case PRIMITIVE_RECTANGLE:
+			MarkLine(grid, mask, p.x1, p.y1, p.x1 + p.x2, p.y1, pad);
+			MarkLine(grid, mask, p.x1, p.y1 + p.y2, p.x1 + p.x2, p.y1 + p.y2, pad);
+			MarkLine(grid, mask, p.x1, p.y1, p.x1, p.y1 + p.y2, pad);
+			MarkLine(grid, mask, p.x1 + p.x2, p.y1, p.x1 + p.x2, p.y1 + p.y2, pad);
+			break;
+
+		case PRIMITIVE_FILLED_RECTANGLE:
+			MarkBox(grid, mask, p.x1 - 2, p.y1 - 2, p.x1 + p.x2 + 2, p.y1 + p.y2 + 2);
+			break;
+	}
+}
+
+/*
+ * Create empty tile bins for tile grid
+ */
+inline void InitTileBins(TileBins &bins, const TileGrid &grid) {
+	InitTileMask(bins.inked, grid);
+	InitTileMask(bins.scratch, grid);
+	bins.primitives.assign((size_t)grid.tilesX * grid.tilesY, std::vector<uint32_t>());
+}
+
+/*
+ * Bin the primitives of the crosshairs into the tiles they touch when drawn with the given padding
+ */
+inline void BinPrimitives(const TileGrid &grid, const Reticle &reticle, float pad, TileBins &bins) {
+	// remove the primitives of the last crosshairs
+	for (int32_t index : bins.inked.marked) {
+		bins.primitives[index].clear();
+	}
+	ClearTileMask(bins.inked);
+	bins.pad = pad;
+
+	for (uint32_t i = 0; i < reticle.primitives.size(); i++) {
+		ClearTileMask(bins.scratch);
+		MarkPrimitive(grid, bins.scratch, reticle.primitives[i], pad);
+
+		for (int32_t index : bins.scratch.marked) {
+			bins.primitives[index].push_back(i);
+			MarkTile(bins.inked, index);
+		}
+	}
+}
+
+/*
+ * Get bounding box of a tile set in pixels, empty if there are no tiles
+ */
+inline TileRect GetTileBounds(const TileGrid &grid, const TileMask &mask) {
+	TileRect bounds = {grid.width, grid.height, 0, 0};
+
+	for (int32_t index : mask.marked) {
+		TileRect rect = GetTileRect(grid, index);
+		bounds.left = (rect.left < bounds.left) ? rect.left : bounds.left;
+		bounds.top = (rect.top < bounds.top) ? rect.top : bounds.top;
+		bounds.right = (rect.right > bounds.right) ? rect.right : bounds.right;
+		bounds.bottom = (rect.bottom > bounds.bottom) ? rect.bottom : bounds.bottom;
+	}
+
+	if (mask.marked.empty()) {
+		bounds.left = 0;
+		bounds.top = 0;
+		bounds.right = 0;
+		bounds.bottom = 0;
+	}
+	return bounds;
+}
+
+/*
+ * Check if two primitives are equal
+ */
+inline bool SamePrimitive(const Primitive &a, const Primitive &b) {
+	return (a.type == b.type) && (a.x1 == b.x1) && (a.y1 == b.y1) && (a.x2 == b.x2) && (a.y2 == b.y2) &&
+		(a.antiAlias == b.antiAlias);
+}
+
+/*
+ * Create empty tile store for a screen
+ */
+inline void InitTileStore(TileStore &store, int32_t width, int32_t height) {
+	InitTileGrid(store.grid, width, height);
+	store.tiles.assign((size_t)store.grid.tilesX * store.grid.tilesY, NULL);
+	store.drawn.assign(store.tiles.size(), std::vector<Primitive>());
+	store.allocatedTiles = 0;
+	store.packed = NULL;
+	store.packedCapacity = 0;
+}
+
+/*
+ * Free all tiles of tile store
+ */
+inline void FreeTileStore(TileStore &store) {
+	for (uint32_t *&tile : store.tiles) {
+		if (!store.packed) {
+			free(tile);
+		}
+		tile = NULL;
+	}
+	store.drawn.clear();
+	store.allocatedTiles = 0;
+	store.packed = NULL;
+	store.packedCapacity = 0;
+}
+
+/*
+ * Set the memory the tiles of the next frame are rendered to, packed one after another in the order of the shown
+ * tiles (e.g. a shared frame), or NULL to allocate each tile separately. Packed tiles are rasterized again every
+ * frame, as their memory changes, separately allocated tiles only when they have changed.
+ */
+inline void SetTileMemory(TileStore &store, uint32_t *packed, size_t capacity) {
+	if (!store.packed != !packed) {
+		// separately allocated tiles are not needed anymore, and packed tiles of earlier frames may be gone
+		for (uint32_t *&tile : store.tiles) {
+			if (!store.packed) {
+				free(tile);
+			}
+			tile = NULL;
+		}
+		store.allocatedTiles = 0;
+	}
+	store.packed = packed;
+	store.packedCapacity = packed ? capacity : 0;
+}
+
+/*
+ * Get pixels of tile, allocating it if necessary, returns NULL if out of memory
+ */
+inline uint32_t *AcquireTile(TileStore &store, int32_t index) {
+	if (!store.tiles[index]) {
+		store.tiles[index] = (uint32_t*)malloc(TILE_PIXELS * sizeof(uint32_t));
+		if (store.tiles[index]) {
+			store.allocatedTiles++;
+		}
+	}
+	return store.tiles[index];
+}
+
+/*
+ * Free tile without geometry
+ */
+inline void ReleaseTile(TileStore &store, int32_t index) {
+	if (store.tiles[index] && !store.packed) {
+		free(store.tiles[index]);
+		store.allocatedTiles--;
+	}
+	store.tiles[index] = NULL;
+	std::vector<Primitive>().swap(store.drawn[index]);
+}
+
+/*
+ * Clip horizontal and vertical lines to a tile padded by pad pixels, so lines only differing beyond the tile
+ * (e.g. crosshairs arms moved by the spread) are equal, other primitives are kept as they are
+ */
+inline Primitive ClipPrimitive(const Primitive &p, const TileRect &rect, float pad) {
+	Primitive clipped = p;
+	if (p.type == PRIMITIVE_LINE) {
+		float left = rect.left - pad;
+		float top = rect.top - pad;
+		float right = rect.right + pad;
+		float bottom = rect.bottom + pad;
+		if (p.y1 == p.y2) {
+			clipped.x1 = (p.x1 < left) ? left : ((p.x1 > right) ? right : p.x1);
+			clipped.x2 = (p.x2 < left) ? left : ((p.x2 > right) ? right : p.x2);
+		} else if (p.x1 == p.x2) {
+			clipped.y1 = (p.y1 < top) ? top : ((p.y1 > bottom) ? bottom : p.y1);
+			clipped.y2 = (p.y2 < top) ? top : ((p.y2 > bottom) ? bottom : p.y2);
+		}
+	}
+	return clipped;
+}
+
+/*
+ * Check if a tile has already been rasterized with the given primitives
+ */
+inline bool IsTileDrawn(const TileStore &store, int32_t index, const Reticle &reticle, const std::vector<uint32_t> &primitives, float pad) {
+	const std::vector<Primitive> &drawn = store.drawn[index];
+	if (!store.tiles[index] || (drawn.size() != primitives.size())) {
+		return false;
+	}
+	TileRect rect = GetTileRect(store.grid, index);
+	for (size_t i = 0; i < primitives.size(); i++) {
+		if (!SamePrimitive(drawn[i], ClipPrimitive(reticle.primitives[primitives[i]], rect, pad))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Update the tiles for the crosshairs binned into bins: free the tiles shown by the last frame without geometry now,
+ * and rasterize the tiles containing geometry whose primitives have changed (all of them if redraw is set, e.g. for a
+ * different pen, or if they are packed). shown is updated to the tiles containing geometry, in the order of packed
+ * tiles, dirty is set to the tiles whose pixels have changed, including the freed ones.
+ */
+inline void UpdateTiles(TileStore &store, const TileBins &bins, const Reticle &reticle, bool redraw,
+		RasterizeTile rasterize, void *context, TileMask &shown, TileMask &dirty) {
+	ClearTileMask(dirty);
+	for (int32_t index : shown.marked) {
+		if (!bins.inked.flags[index]) {
+			ReleaseTile(store, index);
+			MarkTile(dirty, index);
+		}
+	}
+	ClearTileMask(shown);
+
+	for (int32_t index : bins.inked.marked) {
+		const std::vector<uint32_t> &primitives = bins.primitives[index];
+		bool changed = redraw || !IsTileDrawn(store, index, reticle, primitives, bins.pad);
+
+		// tiles which do not fit into the packed memory or cannot be allocated stay transparent
+		uint32_t *pixels;
+		if (store.packed) {
+			if (shown.marked.size() >= store.packedCapacity) {
+				if (store.tiles[index]) {
+					ReleaseTile(store, index);
+					MarkTile(dirty, index);
+				}
+				continue;
+			}
+			pixels = store.packed + shown.marked.size() * TILE_PIXELS;
+			store.tiles[index] = pixels;
+		} else {
+			pixels = AcquireTile(store, index);
+			if (!pixels) {
+				continue;
+			}
+		}
+
+		TileRect rect = GetTileRect(store.grid, index);
+		if (changed || store.packed) {
+			memset(pixels, 0, TILE_PIXELS * sizeof(uint32_t));
+			rasterize(context, pixels, rect, reticle, primitives);
+		}
+
+		if (changed) {
+			std::vector<Primitive> &drawn = store.drawn[index];
+			drawn.clear();
+			for (uint32_t i : primitives) {
+				drawn.push_back(ClipPrimitive(reticle.primitives[i], rect, bins.pad));
+			}
+			MarkTile(dirty, index);
+		}
+		MarkTile(shown, index);
+	}
+}
+
+/*
+ * Copy the pixels of the area (in screen coordinates) to a dense buffer with the given stride in pixels,
+ * whose first pixel is at (originX, originY), tiles without geometry are transparent
+ */
+inline void ComposeTiles(const TileStore &store, const TileRect &area, uint32_t *pixels, int32_t stride, int32_t originX, int32_t originY) {
+	const TileGrid &grid = store.grid;
+
+	for (int32_t y = area.top; y < area.bottom; y++) {
+		int32_t tileY = y / TILE_SIZE;
+		uint32_t *row = pixels + (size_t)(y - originY) * stride;
+
+		int32_t x = area.left;
+		while (x < area.right) {
+			int32_t tileX = x / TILE_SIZE;
+			int32_t end = (tileX + 1) * TILE_SIZE;
+			end = (end > area.right) ? area.right : end;
+
+			const uint32_t *tile = store.tiles[tileY * grid.tilesX + tileX];
+			if (tile) {
+				memcpy(row + (x - originX), tile + (y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE), (end - x) * sizeof(uint32_t));
+			} else {
+				memset(row + (x - originX), 0, (end - x) * sizeof(uint32_t));
+			}
+			x = end;
+		}
+	}
+}
+
+#endif